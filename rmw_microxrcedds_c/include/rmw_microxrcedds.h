@@ -20,14 +20,196 @@
 #include "rmw/get_topic_names_and_types.h"
 #include "rmw/get_service_names_and_types.h"
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
 const char * rmw_get_implementation_identifier(void);
 
-// How do we pass transport to use?.
+/// Entity limits used to size the node memory pools.
+typedef struct rmw_uxrce_limits_t
+{
+  size_t max_nodes;
+  size_t max_publishers_x_node;
+  size_t max_subscriptions_x_node;
+  size_t max_topics_x_node;
+  size_t max_history_x_subscription;
+  size_t max_history;
+} rmw_uxrce_limits_t;
+
+/// Sets the limits applied by the next call to rmw_init.
+/**
+ * Overrides both the rmw_microxrcedds.config defaults and the RMW_UXRCE_MAX_* environment
+ * variables. Without the arena memory mode no limit can exceed its configured maximum.
+ */
+rmw_ret_t rmw_uxrce_set_limits(const rmw_uxrce_limits_t * limits);
+
+/// Gets the limits currently in use.
+rmw_ret_t rmw_uxrce_get_limits(rmw_uxrce_limits_t * limits);
+
+/// Pool utilization since the last rmw_init, per node figures are the maximum over all nodes.
+typedef struct rmw_uxrce_memory_stats_t
+{
+  size_t nodes_in_use;
+  size_t nodes_high_water;
+  size_t publishers_x_node_high_water;
+  size_t subscriptions_x_node_high_water;
+  size_t topics_x_node_high_water;
+} rmw_uxrce_memory_stats_t;
+
+rmw_ret_t rmw_uxrce_get_memory_stats(rmw_uxrce_memory_stats_t * stats);
+
+/// Memory cost in bytes of each entity, including its pool links and buffers.
+typedef struct rmw_uxrce_footprint_t
+{
+  size_t node;
+  size_t publisher;
+  size_t subscription;
+  size_t topic;
+  /// Reliable stream buffer, TCP nodes only use one MTU of it.
+  size_t stream;
+  /// I/O thread publish queue of a node, 0 in sync I/O mode.
+  size_t publish_queue;
+  size_t guard_condition;
+  size_t wait_set;
+
+  /// Node arena holding every node and its entity pools.
+  size_t node_arena;
+  /// Node arena plus the guard condition and wait set pools.
+  size_t total;
+} rmw_uxrce_footprint_t;
+
+/// Computes the footprint for the given limits, or for the limits in use if limits is NULL.
+rmw_ret_t rmw_uxrce_get_footprint(
+  const rmw_uxrce_limits_t * limits,
+  rmw_uxrce_footprint_t * footprint);
+
+/// Transport used to reach the agent.
+typedef enum rmw_uxrce_transport_kind_t
+{
+  RMW_UXRCE_TRANSPORT_UDP,
+  RMW_UXRCE_TRANSPORT_SERIAL,
+  RMW_UXRCE_TRANSPORT_TCP,
+  /// Shared memory segment of an agent on the same host.
+  RMW_UXRCE_TRANSPORT_SHM,
+  /// Application callbacks, see rmw_uxrce_custom_transport_t.
+  RMW_UXRCE_TRANSPORT_CUSTOM
+} rmw_uxrce_transport_kind_t;
+
+#define RMW_UXRCE_ENDPOINT_MAX_LENGTH 64
+
+/// Application provided transport, for links the client library does not know.
+/**
+ * Every callback gets args back. The application owns the receive buffers: read points
+ * buffer at a message of its own, which must stay valid until the next read or close.
+ * Messages handed to write are only valid during the call.
+ */
+typedef struct rmw_uxrce_custom_transport_t
+{
+  void * args;
+  /// Largest message in bytes, at most rmw_uxrce_get_max_mtu.
+  uint16_t mtu;
+  /// Optional, called when a node using the transport is created.
+  bool (* open)(void * args);
+  /// Optional, called when the node is destroyed.
+  void (* close)(void * args);
+  /// Sends a whole message, returns false if it was not sent.
+  bool (* write)(void * args, const uint8_t * buffer, size_t length);
+  /// Waits up to timeout ms for a message, a negative timeout waits forever.
+  bool (* read)(void * args, uint8_t ** buffer, size_t * length, int timeout);
+} rmw_uxrce_custom_transport_t;
+
+/// Agent endpoint, only the fields of the selected kind are used.
+typedef struct rmw_uxrce_transport_params_t
+{
+  rmw_uxrce_transport_kind_t kind;
+  /// UDP and TCP agent address.
+  char agent_ip[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  uint16_t agent_port;
+  /// UDP only, looks for an agent listening on agent_port first, agent_ip is the fallback.
+  bool agent_discovery;
+  char serial_device[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  /// Serial only, one of the standard rates up to 4000000 the platform supports.
+  uint32_t serial_baud_rate;
+  /// Serial only, enables RTS/CTS hardware flow control.
+  bool serial_flow_control;
+  char shm_name[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  /// TCP only, disables Nagle's algorithm.
+  bool tcp_no_delay;
+  /// TCP only, socket send buffer size in bytes, 0 keeps the system default.
+  uint32_t tcp_send_buffer_size;
+  rmw_uxrce_custom_transport_t custom;
+} rmw_uxrce_transport_params_t;
+
+/// Sets the transport of the nodes created from now on.
+/**
+ * Overrides both the rmw_microxrcedds.config defaults and the RMW_UXRCE_TRANSPORT,
+ * RMW_UXRCE_AGENT_IP, RMW_UXRCE_AGENT_PORT, RMW_UXRCE_SERIAL_DEVICE, RMW_UXRCE_SERIAL_BAUD
+ * and RMW_UXRCE_SHM_NAME environment variables read by rmw_init. Calling it between node
+ * creations gives each node its own transport. Setting RMW_UXRCE_AGENT_IP turns
+ * agent_discovery off.
+ */
+rmw_ret_t rmw_uxrce_set_transport(const rmw_uxrce_transport_params_t * params);
+
+/// Gets the transport new nodes use.
+rmw_ret_t rmw_uxrce_get_transport(rmw_uxrce_transport_params_t * params);
+
+/// Makes the nodes created from now on use the application transport.
+/**
+ * Shorthand for rmw_uxrce_set_transport with RMW_UXRCE_TRANSPORT_CUSTOM. The callbacks
+ * are copied, args must outlive the nodes using them.
+ */
+rmw_ret_t rmw_uxrce_set_custom_transport(const rmw_uxrce_custom_transport_t * transport);
+
+/// Largest MTU the stream buffers of this build hold.
+size_t rmw_uxrce_get_max_mtu(void);
+
+/// UDP or TCP agent address of an agent list entry.
+typedef struct rmw_uxrce_agent_endpoint_t
+{
+  char ip[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  uint16_t port;
+} rmw_uxrce_agent_endpoint_t;
+
+/// Sets the agents UDP and TCP nodes connect to.
+/**
+ * Overrides the CONFIG_AGENTS default and the RMW_UXRCE_AGENTS environment variable,
+ * a list of ip:port entries separated by commas. With a list the agent_ip and agent_port
+ * transport params are ignored: a node connects to the first healthy agent and, when
+ * its agent stops answering, moves with its entities to the next one. An agent that
+ * failed is only tried again after CONFIG_AGENT_RETRY_MS unless no other one answers.
+ * With balance_load new nodes go to the healthy agent serving the fewest nodes instead
+ * of the first one. A count of 0 clears the list. At most CONFIG_MAX_AGENTS entries,
+ * and the list can only change while no node is connected to it.
+ */
+rmw_ret_t rmw_uxrce_set_agents(
+  const rmw_uxrce_agent_endpoint_t * agents, size_t count,
+  bool balance_load);
+
+/// Health of an agent list entry.
+typedef struct rmw_uxrce_agent_status_t
+{
+  rmw_uxrce_agent_endpoint_t endpoint;
+  /// Nodes of this process connected to the agent.
+  size_t nodes;
+  /// Connection attempts failed since the last successful one.
+  size_t failures;
+  /// False while the agent waits out the retry delay of its last failure.
+  bool healthy;
+} rmw_uxrce_agent_status_t;
+
+/// Gets the status of the index-th agent of the list.
+/**
+ * Returns RMW_RET_INVALID_ARGUMENT once index is past the end of the list.
+ */
+rmw_ret_t rmw_uxrce_get_agent_status(size_t index, rmw_uxrce_agent_status_t * status);
+
 rmw_ret_t rmw_init(void);
 
 rmw_node_t * rmw_create_node(
   const char * name,
-  const char * namespace,
+  const char * namespace_,
   size_t domain_id,
   const rmw_node_security_options_t * security_options);
 
@@ -197,4 +379,8 @@ rmw_ret_t rmw_get_service_names_and_types(
   rcutils_allocator_t * allocator,
   rmw_names_and_types_t * service_names_and_types);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif  // RMW_MICROXRCEDDS_H_
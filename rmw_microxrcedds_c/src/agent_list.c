@@ -0,0 +1,259 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./agent_list.h"  // NOLINT
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rmw/error_handling.h>
+#include <uxr/client/util/time.h>
+
+#include "./io_thread.h"
+
+typedef struct Agent
+{
+  rmw_uxrce_agent_endpoint_t endpoint;
+  size_t nodes;
+  size_t failures;
+  int64_t retry_time;
+} Agent;
+
+static Agent agents[MAX_AGENTS];
+static size_t agent_count = 0;
+static bool balance_load = false;
+static bool agents_requested = false;
+
+// Parses "ip:port,ip:port", the port follows the last colon of an entry.
+static bool parse_agents(const char * list, rmw_uxrce_agent_endpoint_t * endpoints, size_t * count)
+{
+  *count = 0;
+  while (*list != '\0') {
+    const char * end = strchr(list, ',');
+    if (end == NULL) {
+      end = list + strlen(list);
+    }
+    const char * colon = NULL;
+    for (const char * c = list; c < end; c++) {
+      if (*c == ':') {
+        colon = c;
+      }
+    }
+    if ((colon == NULL) || (colon == list) || (*count == MAX_AGENTS) ||
+      ((size_t)(colon - list) >= RMW_UXRCE_ENDPOINT_MAX_LENGTH))
+    {
+      return false;
+    }
+
+    char * port_end = NULL;
+    unsigned long port = strtoul(colon + 1, &port_end, 10);  // NOLINT
+    if ((port_end != end) || (port == 0) || (port > UINT16_MAX)) {
+      return false;
+    }
+    rmw_uxrce_agent_endpoint_t * endpoint = &endpoints[(*count)++];
+    memcpy(endpoint->ip, list, (size_t)(colon - list));
+    endpoint->ip[colon - list] = '\0';
+    endpoint->port = (uint16_t)port;
+
+    list = (*end == ',') ? end + 1 : end;
+  }
+  return true;
+}
+
+static bool check_agents(const rmw_uxrce_agent_endpoint_t * endpoints, size_t count)
+{
+  if (count > MAX_AGENTS) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if ((endpoints[i].ip[0] == '\0') || (endpoints[i].port == 0) ||
+      (memchr(endpoints[i].ip, '\0', RMW_UXRCE_ENDPOINT_MAX_LENGTH) == NULL))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool agents_in_use(void)
+{
+  for (size_t i = 0; i < agent_count; i++) {
+    if (agents[i].nodes > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void store_agents(const rmw_uxrce_agent_endpoint_t * endpoints, size_t count, bool balance)
+{
+  memset(agents, 0, sizeof(agents));
+  for (size_t i = 0; i < count; i++) {
+    agents[i].endpoint = endpoints[i];
+  }
+  agent_count = count;
+  balance_load = balance;
+}
+
+rmw_ret_t rmw_uxrce_set_agents(
+  const rmw_uxrce_agent_endpoint_t * endpoints, size_t count,
+  bool balance)
+{
+  if ((endpoints == NULL) && (count > 0)) {
+    RMW_SET_ERROR_MSG("agents is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!check_agents(endpoints, count)) {
+    RMW_SET_ERROR_MSG("more agents than CONFIG_MAX_AGENTS or agent endpoint missing");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  lock_memory();
+  if (agents_in_use()) {
+    unlock_memory();
+    RMW_SET_ERROR_MSG("nodes are connected to the current agents");
+    return RMW_RET_ERROR;
+  }
+  store_agents(endpoints, count, balance);
+  agents_requested = true;
+  unlock_memory();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_get_agent_status(size_t index, rmw_uxrce_agent_status_t * status)
+{
+  if (!status) {
+    RMW_SET_ERROR_MSG("status is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  int64_t now = uxr_millis();
+  lock_memory();
+  if (index >= agent_count) {
+    unlock_memory();
+    RMW_SET_ERROR_MSG("agent index out of range");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  status->endpoint = agents[index].endpoint;
+  status->nodes = agents[index].nodes;
+  status->failures = agents[index].failures;
+  status->healthy = now >= agents[index].retry_time;
+  unlock_memory();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t init_agent_list(void)
+{
+  if (agents_requested) {
+    return RMW_RET_OK;
+  }
+
+  rmw_uxrce_agent_endpoint_t endpoints[MAX_AGENTS];
+  size_t count;
+  const char * list = getenv("RMW_UXRCE_AGENTS");
+  if ((list == NULL) || (list[0] == '\0')) {
+    list = DEFAULT_AGENTS;
+  }
+  if (!parse_agents(list, endpoints, &count)) {
+    RMW_SET_ERROR_MSG("invalid RMW_UXRCE_AGENTS environment variable or more agents "
+      "than CONFIG_MAX_AGENTS");
+    return RMW_RET_ERROR;
+  }
+
+#ifdef MICRO_XRCEDDS_AGENT_BALANCE
+  bool balance = true;
+#else
+  bool balance = false;
+#endif
+  lock_memory();
+  if (agents_in_use()) {
+    unlock_memory();
+    return RMW_RET_OK;
+  }
+  store_agents(endpoints, count, balance);
+  unlock_memory();
+  return RMW_RET_OK;
+}
+
+bool agent_list_applies(rmw_uxrce_transport_kind_t kind)
+{
+  lock_memory();
+  bool applies = agent_count > 0;
+  unlock_memory();
+  return applies && ((kind == RMW_UXRCE_TRANSPORT_UDP) || (kind == RMW_UXRCE_TRANSPORT_TCP));
+}
+
+static bool comes_before(const Agent * agent, const Agent * other, int64_t now)
+{
+  bool healthy = now >= agent->retry_time;
+  bool other_healthy = now >= other->retry_time;
+  if (healthy != other_healthy) {
+    return healthy;
+  }
+  if (!healthy) {
+    return agent->retry_time < other->retry_time;
+  }
+  return balance_load && (agent->nodes < other->nodes);
+}
+
+size_t agent_candidates(size_t order[MAX_AGENTS])
+{
+  int64_t now = uxr_millis();
+  lock_memory();
+  // Stable insertion sort, ties keep the list order
+  for (size_t i = 0; i < agent_count; i++) {
+    size_t position = i;
+    while ((position > 0) && comes_before(&agents[i], &agents[order[position - 1]], now)) {
+      order[position] = order[position - 1];
+      position--;
+    }
+    order[position] = i;
+  }
+  size_t count = agent_count;
+  unlock_memory();
+  return count;
+}
+
+void get_agent_endpoint(size_t index, rmw_uxrce_transport_params_t * params)
+{
+  lock_memory();
+  memcpy(params->agent_ip, agents[index].endpoint.ip, RMW_UXRCE_ENDPOINT_MAX_LENGTH);
+  params->agent_port = agents[index].endpoint.port;
+  unlock_memory();
+}
+
+void agent_connected(size_t index)
+{
+  lock_memory();
+  agents[index].nodes++;
+  agents[index].failures = 0;
+  agents[index].retry_time = 0;
+  unlock_memory();
+}
+
+void agent_disconnected(size_t index)
+{
+  lock_memory();
+  agents[index].nodes--;
+  unlock_memory();
+}
+
+void agent_failed(size_t index)
+{
+  int64_t now = uxr_millis();
+  lock_memory();
+  agents[index].failures++;
+  agents[index].retry_time = now + AGENT_RETRY_MS;
+  unlock_memory();
+}
@@ -0,0 +1,57 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AGENT_LIST_H_
+#define AGENT_LIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rmw/types.h>
+
+#include "./config.h"
+#include "./rmw_microxrcedds.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Agent index of nodes connected to the agent of their transport params.
+#define NO_AGENT SIZE_MAX
+
+// Loads the list from CONFIG_AGENTS and RMW_UXRCE_AGENTS, unless rmw_uxrce_set_agents
+// set one.
+rmw_ret_t init_agent_list(void);
+
+// True when nodes of this kind pick their agent from the list.
+bool agent_list_applies(rmw_uxrce_transport_kind_t kind);
+
+// Fills order with the agents to try: healthy ones first, by list order or by node
+// count when balancing, then those still in their retry delay, soonest first.
+size_t agent_candidates(size_t order[MAX_AGENTS]);
+
+// Points the agent address of params at the index-th agent.
+void get_agent_endpoint(size_t index, rmw_uxrce_transport_params_t * params);
+
+void agent_connected(size_t index);
+void agent_disconnected(size_t index);
+void agent_failed(size_t index);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // AGENT_LIST_H_
@@ -0,0 +1,183 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./discovery.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_DISCOVERY
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <uxr/client/util/time.h>
+
+// Probes are resent at this period while no agent answers
+#define PROBE_PERIOD_MS 200
+
+#define SESSION_ID_WITHOUT_CLIENT_KEY 0x80
+#define SUBMESSAGE_ID_GET_INFO 0x02
+#define SUBMESSAGE_ID_INFO 0x06
+#define SUBMESSAGE_FLAG_LITTLE_ENDIAN 0x01
+#define INFO_CONFIGURATION 0x01
+#define INFO_ACTIVITY 0x02
+#define PROBE_REQUEST_ID_0 0x52
+#define PROBE_REQUEST_ID_1 0x44
+
+// XRCE message without session: header, GET_INFO submessage header and payload
+// (request id, agent object id and info mask).
+static const uint8_t probe_message[] = {
+  SESSION_ID_WITHOUT_CLIENT_KEY, 0x00, 0x00, 0x00,
+  SUBMESSAGE_ID_GET_INFO, SUBMESSAGE_FLAG_LITTLE_ENDIAN, 0x08, 0x00,
+  PROBE_REQUEST_ID_0, PROBE_REQUEST_ID_1, 0xFF, 0xFD,
+  INFO_CONFIGURATION | INFO_ACTIVITY, 0x00, 0x00, 0x00
+};
+
+// An INFO reply to the probe starts with the request id it relates to.
+static bool is_probe_reply(const uint8_t * message, ssize_t length)
+{
+  return (length >= 10) && (message[4] == SUBMESSAGE_ID_INFO) &&
+         (message[8] == PROBE_REQUEST_ID_0) && (message[9] == PROBE_REQUEST_ID_1);
+}
+
+bool probe_agent_address(
+  const char * ip, uint16_t port, int timeout,
+  char agent_ip[], size_t agent_ip_size, uint16_t * agent_port)
+{
+  struct sockaddr_in probe_addr;
+  memset(&probe_addr, 0, sizeof(probe_addr));
+  probe_addr.sin_family = AF_INET;
+  probe_addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, ip, &probe_addr.sin_addr) != 1) {
+    return false;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  int broadcast = 1;
+  setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+  bool found = false;
+  int64_t deadline = uxr_millis() + timeout;
+  int64_t next_probe = 0;
+  int64_t now;
+  while (!found && ((now = uxr_millis()) < deadline)) {
+    if (now >= next_probe) {
+      sendto(fd, probe_message, sizeof(probe_message), 0, (struct sockaddr *)&probe_addr,
+        sizeof(probe_addr));
+      next_probe = now + PROBE_PERIOD_MS;
+    }
+
+    int64_t wait = ((next_probe < deadline) ? next_probe : deadline) - now;
+    struct pollfd poll_fd = {fd, POLLIN, 0};
+    if (poll(&poll_fd, 1, (int)wait) <= 0) {
+      continue;
+    }
+
+    // The reply comes from the socket the agent serves clients on
+    uint8_t reply[UXR_CONFIG_UDP_TRANSPORT_MTU];
+    struct sockaddr_in agent_addr;
+    socklen_t agent_addr_length = sizeof(agent_addr);
+    ssize_t length = recvfrom(fd, reply, sizeof(reply), 0, (struct sockaddr *)&agent_addr,
+        &agent_addr_length);
+    if (is_probe_reply(reply, length) &&
+      (inet_ntop(AF_INET, &agent_addr.sin_addr, agent_ip, (socklen_t)agent_ip_size) != NULL))
+    {
+      *agent_port = ntohs(agent_addr.sin_port);
+      found = true;
+    }
+  }
+
+  close(fd);
+  return found;
+}
+
+static bool read_cache(const char * cache_path, char ip[], size_t ip_size, uint16_t * port)
+{
+  FILE * file = fopen(cache_path, "r");
+  if (file == NULL) {
+    return false;
+  }
+  char line[64];
+  bool valid = fgets(line, sizeof(line), file) != NULL;
+  fclose(file);
+
+  char * colon = valid ? strrchr(line, ':') : NULL;
+  if ((colon == NULL) || ((size_t)(colon - line) >= ip_size)) {
+    return false;
+  }
+  char * end = NULL;
+  unsigned long parsed = strtoul(colon + 1, &end, 10);  // NOLINT
+  if ((end == colon + 1) || ((*end != '\n') && (*end != '\0')) || (parsed == 0) ||
+    (parsed > UINT16_MAX))
+  {
+    return false;
+  }
+  memcpy(ip, line, (size_t)(colon - line));
+  ip[colon - line] = '\0';
+  *port = (uint16_t)parsed;
+  return true;
+}
+
+static void write_cache(const char * cache_path, const char * ip, uint16_t port)
+{
+  // Written aside and renamed, a reset while writing leaves the old entry
+  char temporary_path[256];
+  if (snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", cache_path) >=
+    (int)sizeof(temporary_path))
+  {
+    return;
+  }
+  FILE * file = fopen(temporary_path, "w");
+  if (file == NULL) {
+    return;
+  }
+  bool written = fprintf(file, "%s:%hu\n", ip, port) > 0;
+  written &= fclose(file) == 0;
+  if (!written || (rename(temporary_path, cache_path) != 0)) {
+    remove(temporary_path);
+  }
+}
+
+bool discover_agent(
+  const char * cache_path, const char * probe_ip, uint16_t port,
+  char agent_ip[], size_t agent_ip_size, uint16_t * agent_port)
+{
+  bool use_cache = cache_path[0] != '\0';
+  char cached_ip[64];
+  uint16_t cached_port;
+  if (use_cache && read_cache(cache_path, cached_ip, sizeof(cached_ip), &cached_port) &&
+    probe_agent_address(cached_ip, cached_port, DISCOVERY_CACHE_TIMEOUT_MS, agent_ip,
+    agent_ip_size, agent_port))
+  {
+    return true;
+  }
+
+  if (!probe_agent_address(probe_ip, port, DISCOVERY_TIMEOUT_MS, agent_ip, agent_ip_size,
+    agent_port))
+  {
+    return false;
+  }
+  if (use_cache) {
+    write_cache(cache_path, agent_ip, *agent_port);
+  }
+  return true;
+}
+
+#endif  // MICRO_XRCEDDS_DISCOVERY
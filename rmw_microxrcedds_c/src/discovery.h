@@ -0,0 +1,49 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DISCOVERY_H_
+#define DISCOVERY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./config.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#ifdef MICRO_XRCEDDS_DISCOVERY
+// Sends XRCE GET_INFO probes to ip:port until an agent answers or timeout ms go by.
+// A broadcast ip reaches every agent of the network listening on port, the first to
+// answer is picked. Returns false if none answered.
+bool probe_agent_address(
+  const char * ip, uint16_t port, int timeout,
+  char agent_ip[], size_t agent_ip_size, uint16_t * agent_port);
+
+// Looks for an agent on port: first the one in cache_path with a short timeout, then
+// through a probe to probe_ip. The agent found is written back to cache_path, an empty
+// cache_path disables the cache.
+bool discover_agent(
+  const char * cache_path, const char * probe_ip, uint16_t port,
+  char agent_ip[], size_t agent_ip_size, uint16_t * agent_port);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // DISCOVERY_H_
@@ -0,0 +1,83 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./io_queue.h"  // NOLINT
+
+
+void init_io_queue(struct IoQueue * queue, IoQueueCell * cells, size_t capacity)
+{
+  queue->cells = cells;
+  queue->capacity = capacity;
+  for (size_t i = 0; i < capacity; i++) {
+    __atomic_store_n(&cells[i].sequence, i, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&queue->enqueue_position, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&queue->dequeue_position, 0, __ATOMIC_RELEASE);
+}
+
+IoQueueCell * io_queue_reserve(struct IoQueue * queue, size_t * position)
+{
+  if (queue->capacity == 0) {
+    return NULL;
+  }
+
+  size_t current = __atomic_load_n(&queue->enqueue_position, __ATOMIC_RELAXED);
+  while (true) {
+    IoQueueCell * cell = &queue->cells[current & (queue->capacity - 1)];
+    size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)current;
+    if (difference == 0) {
+      // Free for this position, claim it unless another producer was faster
+      if (__atomic_compare_exchange_n(&queue->enqueue_position, &current, current + 1, true,
+        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        *position = current;
+        return cell;
+      }
+    } else if (difference < 0) {
+      // Still holds the sample of the previous lap
+      return NULL;
+    } else {
+      current = __atomic_load_n(&queue->enqueue_position, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void io_queue_commit(IoQueueCell * cell, size_t position)
+{
+  __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+IoQueueCell * io_queue_front(struct IoQueue * queue)
+{
+  if (queue->capacity == 0) {
+    return NULL;
+  }
+
+  size_t current = queue->dequeue_position;
+  IoQueueCell * cell = &queue->cells[current & (queue->capacity - 1)];
+  if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != current + 1) {
+    return NULL;
+  }
+  return cell;
+}
+
+void io_queue_pop(struct IoQueue * queue)
+{
+  size_t current = queue->dequeue_position;
+  IoQueueCell * cell = &queue->cells[current & (queue->capacity - 1)];
+  // Hand the cell back to the producer that wraps around to it
+  __atomic_store_n(&cell->sequence, current + queue->capacity, __ATOMIC_RELEASE);
+  queue->dequeue_position = current + 1;
+}
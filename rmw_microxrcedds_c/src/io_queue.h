@@ -0,0 +1,68 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IO_QUEUE_H_
+#define IO_QUEUE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <uxr/client/client.h>
+
+#include "./config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Serialized sample waiting to be written into a reliable output stream. A cell
+// committed with a zero length is skipped by the consumer.
+typedef struct IoQueueCell
+{
+  size_t sequence;
+  uxrObjectId datawriter_id;
+  size_t length;
+  uint8_t data[MAX_TRANSPORT_MTU];
+} IoQueueCell;
+
+// Bounded lock-free queue for many producers and a single consumer. Each cell
+// sequence tells whether it is free for the producer at that position or ready for
+// the consumer, so producers only compete on enqueue_position. capacity must be a
+// power of two.
+struct IoQueue
+{
+  IoQueueCell * cells;
+  size_t capacity;
+  size_t enqueue_position;
+  size_t dequeue_position;
+};
+
+void init_io_queue(struct IoQueue * queue, IoQueueCell * cells, size_t capacity);
+
+// Producer side, returns NULL if the queue is full. The cell belongs to the caller
+// until it is handed over with io_queue_commit.
+IoQueueCell * io_queue_reserve(struct IoQueue * queue, size_t * position);
+void io_queue_commit(IoQueueCell * cell, size_t position);
+
+// Consumer side, returns NULL if the oldest cell is not committed yet.
+IoQueueCell * io_queue_front(struct IoQueue * queue);
+void io_queue_pop(struct IoQueue * queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // IO_QUEUE_H_
@@ -0,0 +1,340 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./io_thread.h"  // NOLINT
+
+#include "./transport.h"
+
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include <rmw/error_handling.h>
+
+#include "./io_queue.h"
+#include "./liveliness.h"
+
+static pthread_mutex_t memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// macOS has no pthread_condattr_setclock, its condition variables wait on the realtime
+// clock
+#ifdef __APPLE__
+#define COND_CLOCK CLOCK_REALTIME
+#else
+#define COND_CLOCK CLOCK_MONOTONIC
+#endif
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+#if (IO_QUEUE_SIZE == 0) || ((IO_QUEUE_SIZE & (IO_QUEUE_SIZE - 1)) != 0)
+#error "CONFIG_IO_QUEUE_SIZE must be a power of two"
+#endif
+
+static void flush_publish_queue(CustomNode * node)
+{
+  IoQueueCell * cell;
+  while ((cell = io_queue_front(&node->publish_queue)) != NULL) {
+    if (cell->length > 0) {
+      ucdrBuffer mb;
+      if (!uxr_prepare_output_stream(&node->session, node->reliable_output, cell->datawriter_id,
+        &mb, (uint32_t)cell->length))
+      {
+        // Reliable stream history is full, retry once the agent acknowledges
+        return;
+      }
+      memcpy(mb.iterator, cell->data, cell->length);
+    }
+    io_queue_pop(&node->publish_queue);
+  }
+}
+
+static void * io_thread_main(void * args)
+{
+  CustomNode * node = (CustomNode *)args;
+  while (__atomic_load_n(&node->io_running, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_lock(&node->session_mutex);
+    if (check_agent_liveliness(node)) {
+      flush_publish_queue(node);
+    }
+    uxr_run_session_time(&node->session, SESSION_SLICE_MS);
+    flush_node_transport(node);
+    pthread_mutex_unlock(&node->session_mutex);
+
+    // Mutexes are not fair, let pending user threads in before taking it again
+    while (__atomic_load_n(&node->session_waiters, __ATOMIC_ACQUIRE) > 0) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+#endif  // MICRO_XRCEDDS_USE_IO_THREAD
+
+static void destroy_node_locks(CustomNode * node)
+{
+  pthread_cond_destroy(&node->history_cond);
+  pthread_mutex_destroy(&node->history_mutex);
+  pthread_mutex_destroy(&node->session_mutex);
+}
+
+bool start_node_io(CustomNode * node)
+{
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+  pthread_condattr_setclock(&cond_attr, COND_CLOCK);
+#endif
+
+  pthread_mutex_init(&node->session_mutex, NULL);
+  pthread_mutex_init(&node->history_mutex, NULL);
+  pthread_cond_init(&node->history_cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+  node->session_waiters = 0;
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  init_io_queue(&node->publish_queue, node->publish_queue.cells, node->publish_queue.capacity);
+  __atomic_store_n(&node->io_running, true, __ATOMIC_RELEASE);
+  if (pthread_create(&node->io_thread, NULL, io_thread_main, node) != 0) {
+    __atomic_store_n(&node->io_running, false, __ATOMIC_RELEASE);
+    destroy_node_locks(node);
+    RMW_SET_ERROR_MSG("failed to start node I/O thread");
+    return false;
+  }
+#endif
+
+  __atomic_store_n(&node->io_ready, true, __ATOMIC_RELEASE);
+  return true;
+}
+
+void stop_node_io(CustomNode * node)
+{
+  if (!__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  __atomic_store_n(&node->io_running, false, __ATOMIC_RELEASE);
+  pthread_join(node->io_thread, NULL);
+
+  // Samples still queued are written before the session goes away
+  flush_publish_queue(node);
+  uxr_flash_output_streams(&node->session);
+#endif
+
+  __atomic_store_n(&node->io_ready, false, __ATOMIC_RELEASE);
+  destroy_node_locks(node);
+}
+
+void lock_session(CustomNode * node)
+{
+  if (!__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  __atomic_add_fetch(&node->session_waiters, 1, __ATOMIC_ACQ_REL);
+  pthread_mutex_lock(&node->session_mutex);
+  __atomic_sub_fetch(&node->session_waiters, 1, __ATOMIC_ACQ_REL);
+}
+
+void unlock_session(CustomNode * node)
+{
+  flush_node_transport(node);
+  if (__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_unlock(&node->session_mutex);
+  }
+}
+
+void lock_history(CustomNode * node)
+{
+  if (__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_lock(&node->history_mutex);
+  }
+}
+
+void unlock_history(CustomNode * node)
+{
+  if (__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_unlock(&node->history_mutex);
+  }
+}
+
+void notify_samples(CustomNode * node)
+{
+  if (__atomic_load_n(&node->io_ready, __ATOMIC_ACQUIRE)) {
+    pthread_cond_broadcast(&node->history_cond);
+  }
+}
+
+void lock_memory(void)
+{
+  pthread_mutex_lock(&memory_mutex);
+}
+
+void unlock_memory(void)
+{
+  pthread_mutex_unlock(&memory_mutex);
+}
+
+static int elapsed_ms(const struct timespec * start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+void run_session_until_status(CustomNode * node, int timeout, size_t request_count)
+{
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int remaining = timeout;
+  while (true) {
+    int slice = ((remaining < 0) || (remaining > SESSION_SLICE_MS)) ? SESSION_SLICE_MS : remaining;
+    if (uxr_run_session_until_one_status(&node->session, slice, node->wait_requests,
+      node->wait_status, request_count))
+    {
+      return;
+    }
+
+    if (timeout >= 0) {
+      remaining = timeout - elapsed_ms(&start);
+      if (remaining <= 0) {
+        return;
+      }
+    }
+
+    // Let publishers on other threads use the session
+    unlock_session(node);
+    lock_session(node);
+  }
+}
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+bool queue_publish(CustomPublisher * publisher, const void * ros_message, uint32_t topic_length)
+{
+  CustomNode * node = publisher->owner_node;
+  if (topic_length > MAX_TRANSPORT_MTU) {
+    RMW_SET_ERROR_MSG("message does not fit in the publish queue");
+    return false;
+  }
+
+  size_t position;
+  IoQueueCell * cell = io_queue_reserve(&node->publish_queue, &position);
+  if (!cell) {
+    RMW_SET_ERROR_MSG("publish queue is full");
+    return false;
+  }
+
+  ucdrBuffer mb;
+  ucdr_init_buffer(&mb, cell->data, topic_length);
+  bool written = publisher->type_support_callbacks->cdr_serialize(ros_message, &mb);
+
+  // A failed serialization still has to release the cell
+  cell->datawriter_id = publisher->datawriter_id;
+  cell->length = written ? topic_length : 0;
+  io_queue_commit(cell, position);
+  return written;
+}
+
+static bool samples_available(const rmw_subscriptions_t * subscriptions)
+{
+  for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
+    CustomSubscription * custom_subscription =
+      (CustomSubscription *)subscriptions->subscribers[i];
+    if ((custom_subscription != NULL) && (custom_subscription->history_count > 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void wait_for_samples(CustomNode * node, const rmw_subscriptions_t * subscriptions, int timeout)
+{
+  struct timespec deadline;
+  clock_gettime(COND_CLOCK, &deadline);
+  if (timeout > 0) {
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&node->history_mutex);
+  while ((timeout != 0) && !samples_available(subscriptions)) {
+    if (timeout < 0) {
+      pthread_cond_wait(&node->history_cond, &node->history_mutex);
+    } else if (pthread_cond_timedwait(&node->history_cond, &node->history_mutex,
+      &deadline) != 0)
+    {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&node->history_mutex);
+}
+
+#endif  // MICRO_XRCEDDS_USE_IO_THREAD
+
+#else
+
+bool start_node_io(CustomNode * node)
+{
+  (void)node;
+  return true;
+}
+
+void stop_node_io(CustomNode * node)
+{
+  (void)node;
+}
+
+void lock_session(CustomNode * node)
+{
+  (void)node;
+}
+
+void unlock_session(CustomNode * node)
+{
+  flush_node_transport(node);
+}
+
+void lock_history(CustomNode * node)
+{
+  (void)node;
+}
+
+void unlock_history(CustomNode * node)
+{
+  (void)node;
+}
+
+void notify_samples(CustomNode * node)
+{
+  (void)node;
+}
+
+void lock_memory(void)
+{
+}
+
+void unlock_memory(void)
+{
+}
+
+void run_session_until_status(CustomNode * node, int timeout, size_t request_count)
+{
+  uxr_run_session_until_one_status(&node->session, timeout, node->wait_requests,
+    node->wait_status, request_count);
+}
+
+#endif  // MICRO_XRCEDDS_THREAD_SAFE
@@ -0,0 +1,64 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IO_THREAD_H_
+#define IO_THREAD_H_
+
+#include <rmw/types.h>
+
+#include "./types.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// With MICRO_XRCEDDS_THREAD_SAFE every node has a session lock, taken to buffer
+// requests or run the session, and a history lock for its subscription histories,
+// always taken in that order. With MICRO_XRCEDDS_USE_IO_THREAD the session also runs
+// in its own thread. Without them all of these are no-ops.
+bool start_node_io(CustomNode * node);
+void stop_node_io(CustomNode * node);
+
+void lock_session(CustomNode * node);
+void unlock_session(CustomNode * node);
+void lock_history(CustomNode * node);
+void unlock_history(CustomNode * node);
+
+// Called with the history lock held after a sample is stored.
+void notify_samples(CustomNode * node);
+
+// Guards the process wide node, guard condition and wait set pools.
+void lock_memory(void);
+void unlock_memory(void);
+
+// Runs the session until one of the node wait requests gets a status or timeout ms go
+// by, a negative timeout waits forever. Called with the session lock held, which is
+// released between slices.
+void run_session_until_status(CustomNode * node, int timeout, size_t request_count);
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+// Serializes the message into the publish queue, the I/O thread writes it.
+bool queue_publish(CustomPublisher * publisher, const void * ros_message, uint32_t topic_length);
+
+// Blocks until one of the subscriptions has samples or timeout ms go by, a negative
+// timeout waits forever.
+void wait_for_samples(CustomNode * node, const rmw_subscriptions_t * subscriptions, int timeout);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // IO_THREAD_H_
@@ -0,0 +1,179 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./liveliness.h"  // NOLINT
+
+#include <rmw/error_handling.h>
+#include <uxr/client/util/time.h>
+
+#include "./agent_list.h"
+#include "./memory.h"
+#include "./rmw_microxrcedds_topic.h"
+#include "./rmw_node.h"
+#include "./rmw_publisher.h"
+#include "./rmw_subscriber.h"
+#include "./utils.h"
+
+static void set_agent_alive(CustomNode * node, bool alive)
+{
+  __atomic_store_n(&node->agent_alive, alive, __ATOMIC_RELEASE);
+}
+
+static bool run_requests(CustomNode * node, uint16_t * requests, size_t request_count)
+{
+  uint8_t status[2];
+  for (size_t i = 0; i < request_count; ++i) {
+    if (requests[i] == UXR_INVALID_REQUEST_ID) {
+      return false;
+    }
+  }
+  return uxr_run_session_until_all_status(&node->session, LIVELINESS_TIMEOUT_MS, requests,
+           status, request_count);
+}
+
+// A participant creation in reuse mode changes nothing on an agent that still knows
+// the session and gets no answer from one that restarted.
+static bool probe_agent(CustomNode * node)
+{
+  uint16_t request = buffer_create_participant(node, UXR_REUSE);
+  if (request == UXR_INVALID_REQUEST_ID) {
+    return false;
+  }
+
+  uint8_t status = UXR_STATUS_NONE;
+  uxr_run_session_until_all_status(&node->session, LIVELINESS_TIMEOUT_MS, &request,
+    &status, 1);
+  return status != UXR_STATUS_NONE;
+}
+
+// Entities are created again with the ids they already have, so handles held by the
+// user stay valid.
+static bool replay_entities(CustomNode * node)
+{
+  uint16_t requests[2];
+
+  requests[0] = buffer_create_participant(node, ENTITY_CREATION_MODE);
+  if (!run_requests(node, requests, 1)) {
+    return false;
+  }
+
+  custom_topic_t * topic = (custom_topic_t *)first_allocated(&node->topic_mem);
+  while (topic != NULL) {
+    requests[0] = buffer_create_topic(topic, ENTITY_CREATION_MODE);
+    topic->sync_with_agent = run_requests(node, requests, 1);
+    if (!topic->sync_with_agent) {
+      return false;
+    }
+    topic = (custom_topic_t *)next_allocated(&node->topic_mem, topic);
+  }
+
+  CustomPublisher * publisher = (CustomPublisher *)first_allocated(&node->publisher_mem);
+  while (publisher != NULL) {
+    if (!buffer_create_publisher(publisher, ENTITY_CREATION_MODE, requests) ||
+      !run_requests(node, requests, 2))
+    {
+      return false;
+    }
+    publisher = (CustomPublisher *)next_allocated(&node->publisher_mem, publisher);
+  }
+
+  CustomSubscription * subscription =
+    (CustomSubscription *)first_allocated(&node->subscription_mem);
+  while (subscription != NULL) {
+    if (!buffer_create_subscriber(subscription, ENTITY_CREATION_MODE, requests) ||
+      !run_requests(node, requests, 2))
+    {
+      return false;
+    }
+    // Pending data requests died with the old session
+    subscription->waiting_for_response = false;
+    subscription->requested_samples = 0;
+    subscription = (CustomSubscription *)next_allocated(&node->subscription_mem, subscription);
+  }
+
+  return true;
+}
+
+static bool recover_session(CustomNode * node)
+{
+  // A single bounded attempt per check, so the session lock is released between
+  // attempts. An agent that restarted takes the session back, a node of the agent list
+  // moves to the best candidate of the list instead.
+  bool connected;
+  if (node->transport_open && (node->agent_index == NO_AGENT)) {
+    init_node_session(node);
+    connected = uxr_create_session_retries(&node->session, RECOVERY_ATTEMPTS);
+  } else {
+    connected = failover_node_session(node);
+  }
+  if (!connected) {
+    return false;
+  }
+  if (!replay_entities(node)) {
+    RMW_SET_ERROR_MSG("failed to recreate node entities on the agent");
+    return false;
+  }
+  return true;
+}
+
+void init_agent_liveliness(CustomNode * node)
+{
+  node->last_liveliness_check = uxr_millis();
+  set_agent_alive(node, true);
+}
+
+bool check_agent_liveliness(CustomNode * node)
+{
+  if (LIVELINESS_PERIOD_MS == 0) {
+    return true;
+  }
+
+  int64_t now = uxr_millis();
+  if ((now - node->last_liveliness_check) < LIVELINESS_PERIOD_MS) {
+    return agent_reachable(node);
+  }
+  node->last_liveliness_check = now;
+
+  if (agent_reachable(node)) {
+    if (probe_agent(node)) {
+      return true;
+    }
+    set_agent_alive(node, false);
+  }
+
+  bool recovered = recover_session(node);
+  set_agent_alive(node, recovered);
+  node->last_liveliness_check = uxr_millis();
+  return recovered;
+}
+
+void report_agent_activity(CustomNode * node, bool confirmed)
+{
+#ifdef MICRO_XRCEDDS_TCP
+  // Best effort streams confirm nothing, TCP nodes rely on the periodic probe
+  if (node->transport_kind == RMW_UXRCE_TRANSPORT_TCP) {
+    return;
+  }
+#endif
+  if (confirmed) {
+    node->last_liveliness_check = uxr_millis();
+  } else {
+    node->last_liveliness_check = 0;
+  }
+}
+
+bool agent_reachable(CustomNode * node)
+{
+  return __atomic_load_n(&node->agent_alive, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,43 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIVELINESS_H_
+#define LIVELINESS_H_
+
+#include "./types.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+void init_agent_liveliness(CustomNode * node);
+
+// Probes the agent at most once every LIVELINESS_PERIOD_MS. Once it is lost, every
+// period the session is created again and the node entities are replayed from the
+// node pools. Called with the session lock held, returns whether the agent is usable.
+bool check_agent_liveliness(CustomNode * node);
+
+// Reports the outcome of a confirmed exchange. Success postpones the next probe, a
+// failure makes the next check probe right away.
+void report_agent_activity(CustomNode * node, bool confirmed);
+
+// Lock free, used to fail fast while the agent is lost.
+bool agent_reachable(CustomNode * node);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // LIVELINESS_H_
@@ -15,102 +15,99 @@
 #include "./memory.h"  // NOLINT
 
 
-void link_next(struct Item * current, struct Item * next, void * data)
+static void * element_at(struct MemPool * mem, mem_index_t index)
 {
-  if (current) {
-    current->next = next;
-    if (next) {
-      next->prev = current;
-    }
-    current->data = data;
-  }
+  return (index == MEM_INDEX_NONE) ? NULL : mem->slab + (size_t)index * mem->element_size;
 }
 
-void link_prev(struct Item * previous, struct Item * current, void * data)
+static mem_index_t index_of(struct MemPool * mem, void * element)
 {
-  if (current) {
-    current->prev = previous;
-    if (previous) {
-      previous->next = current;
-    }
-    current->data = data;
-  }
+  return (mem_index_t)(((uint8_t *)element - mem->slab) / mem->element_size);
 }
 
-void set_mem_pool(struct MemPool * mem, struct Item * first)
+void init_mem_pool(
+  struct MemPool * mem, void * slab, size_t element_size, struct MemLink * links,
+  size_t capacity)
 {
-  mem->freeitems = first;
-  mem->allocateditems = NULL;
+  mem->slab = (uint8_t *)slab;
+  mem->links = links;
+  mem->element_size = element_size;
+  mem->capacity = (capacity > MEM_POOL_MAX_CAPACITY) ? MEM_POOL_MAX_CAPACITY : capacity;
+  mem->high_water = 0;
+  free_mem_pool(mem);
 }
 
 void free_mem_pool(struct MemPool * mem)
 {
-  if (mem->allocateditems) {
-    struct Item * old_free_head = mem->freeitems;
-    mem->freeitems = mem->allocateditems;
-    mem->freeitems->prev = NULL;
-    mem->allocateditems = NULL;
-
-    struct Item * free_item = mem->freeitems;
-    while (free_item->next) {
-      free_item = free_item->next;
-    }
-    free_item->next = old_free_head;
-    old_free_head->prev = free_item;
-  }
+  mem->allocated_head = MEM_INDEX_NONE;
+  mem->free_head = MEM_INDEX_NONE;
+  mem->bump_index = 0;
+  mem->in_use = 0;
 }
 
 bool has_memory(struct MemPool * mem)
 {
-  return mem->freeitems != NULL ? true : false;
+  return (mem->free_head != MEM_INDEX_NONE) || (mem->bump_index < mem->capacity);
 }
 
-struct Item * get_memory(struct MemPool * mem)
+void * get_memory(struct MemPool * mem)
 {
-  struct Item * item = NULL;
-  if (has_memory(mem)) {
+  mem_index_t index;
+  if (mem->free_head != MEM_INDEX_NONE) {
     // Gets item from free pool
-    item = mem->freeitems;
-    mem->freeitems = item->next;
-    if (mem->freeitems) {
-      mem->freeitems->prev = NULL;
-    }
+    index = mem->free_head;
+    mem->free_head = mem->links[index].next;
+  } else if (mem->bump_index < mem->capacity) {
+    // Gets a never used item
+    index = mem->bump_index++;
+  } else {
+    return NULL;
+  }
+
+  // Puts item in allocated pool
+  struct MemLink * link = &mem->links[index];
+  link->prev = MEM_INDEX_NONE;
+  link->next = mem->allocated_head;
+  if (link->next != MEM_INDEX_NONE) {
+    mem->links[link->next].prev = index;
+  }
+  mem->allocated_head = index;
 
-    // Puts item in allocated pool
-    item->next = mem->allocateditems;
-    if (item->next) {
-      item->next->prev = item;
-    }
-    item->prev = NULL;
-    mem->allocateditems = item;
+  mem->in_use++;
+  if (mem->in_use > mem->high_water) {
+    mem->high_water = mem->in_use;
   }
-  return item;
+  return element_at(mem, index);
 }
 
-void put_memory(struct MemPool * mem, struct Item * item)
+void put_memory(struct MemPool * mem, void * element)
 {
+  mem_index_t index = index_of(mem, element);
+  struct MemLink * link = &mem->links[index];
+
   // Gets item from allocated pool
-  if (item->prev) {
-    item->prev->next = item->next;
+  if (link->prev != MEM_INDEX_NONE) {
+    mem->links[link->prev].next = link->next;
+  } else {
+    mem->allocated_head = link->next;
   }
-  if (item->next) {
-    item->next->prev = item->prev;
+  if (link->next != MEM_INDEX_NONE) {
+    mem->links[link->next].prev = link->prev;
   }
 
-  if (mem->allocateditems == item) {
-    mem->allocateditems = item->next;
-  }
+  // Puts item in free pool
+  link->prev = MEM_INDEX_NONE;
+  link->next = mem->free_head;
+  mem->free_head = index;
+  mem->in_use--;
+}
 
-  // if (mem->freeitems)
-  // {
-  //     mem->freeitems->prev    = NULL;
-  // }
+void * first_allocated(struct MemPool * mem)
+{
+  return element_at(mem, mem->allocated_head);
+}
 
-  // Puts item in free pool
-  item->next = mem->freeitems;
-  if (item->next) {
-    item->next->prev = item;
-  }
-  item->prev = NULL;
-  mem->freeitems = item;
+void * next_allocated(struct MemPool * mem, void * element)
+{
+  return element_at(mem, mem->links[index_of(mem, element)].next);
 }
@@ -17,27 +17,57 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-struct Item
+#ifdef __cplusplus
+extern "C"
 {
-  struct Item * prev;
-  struct Item * next;
-  void * data;
+#endif
+
+#define MEM_INDEX_NONE UINT16_MAX
+#define MEM_POOL_MAX_CAPACITY UINT16_MAX
+
+typedef uint16_t mem_index_t;
+
+// Links of one slab element, either in the free list (next only) or in the
+// allocated list.
+struct MemLink
+{
+  mem_index_t prev;
+  mem_index_t next;
 };
+
+// Pool of capacity elements of element_size bytes stored contiguously in slab.
+// Elements below bump_index that are not allocated sit in the free list, the ones
+// above it have never been used, so a bulk reset only rewinds the bump index.
 struct MemPool
 {
-  struct Item * allocateditems;
-  struct Item * freeitems;
+  uint8_t * slab;
+  struct MemLink * links;
+  size_t element_size;
+  size_t capacity;
+
+  mem_index_t allocated_head;
+  mem_index_t free_head;
+  mem_index_t bump_index;
 
-  size_t size;
+  size_t in_use;
+  size_t high_water;
 };
 
-void link_next(struct Item * current, struct Item * next, void * data);
-void link_prev(struct Item * previous, struct Item * current, void * data);
-void set_mem_pool(struct MemPool * mem, struct Item * first);
+void init_mem_pool(
+  struct MemPool * mem, void * slab, size_t element_size, struct MemLink * links,
+  size_t capacity);
 bool has_memory(struct MemPool * mem);
-struct Item * get_memory(struct MemPool * mem);
-void put_memory(struct MemPool * mem, struct Item * item);
+void * get_memory(struct MemPool * mem);
+void put_memory(struct MemPool * mem, void * element);
 void free_mem_pool(struct MemPool * mem);
 
+void * first_allocated(struct MemPool * mem);
+void * next_allocated(struct MemPool * mem, void * element);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif  // MEMORY_H_
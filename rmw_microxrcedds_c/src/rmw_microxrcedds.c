@@ -15,7 +15,6 @@
 #include "./rmw_microxrcedds.h"  // NOLINT
 
 #include <limits.h>
-#include <time.h>
 
 #include <uxr/client/client.h>
 #include <rosidl_typesupport_microxrcedds_shared/identifier.h>
@@ -25,6 +24,8 @@
 
 #include "./identifier.h"
 
+#include "./io_thread.h"
+#include "./liveliness.h"
 #include "./rmw_node.h"
 #include "./rmw_publisher.h"
 #include "./rmw_subscriber.h"
@@ -32,6 +33,14 @@
 #include "./utils.h"
 
 
+static struct MemPool guard_condition_memory;
+static rmw_guard_condition_t guard_conditions[MAX_GUARD_CONDITIONS];
+static struct MemLink guard_condition_links[MAX_GUARD_CONDITIONS];
+
+static struct MemPool wait_set_memory;
+static rmw_wait_set_t wait_sets[MAX_WAIT_SETS];
+static struct MemLink wait_set_links[MAX_WAIT_SETS];
+
 const char * rmw_get_implementation_identifier()
 {
   EPROS_PRINT_TRACE()
@@ -42,14 +51,15 @@ rmw_ret_t rmw_init()
 {
   EPROS_PRINT_TRACE()
 
-  // Intialize random number generator
-  time_t t;
-  srand((unsigned)time(&t));
+  init_mem_pool(&guard_condition_memory, guard_conditions, sizeof(rmw_guard_condition_t),
+    guard_condition_links, MAX_GUARD_CONDITIONS);
+  init_mem_pool(&wait_set_memory, wait_sets, sizeof(rmw_wait_set_t), wait_set_links,
+    MAX_WAIT_SETS);
 
-  init_rmw_node();
+  rmw_ret_t ret = init_rmw_node();
 
   EPROS_PRINT_TRACE()
-  return RMW_RET_OK;
+  return ret;
 }
 
 rmw_node_t * rmw_create_node(
@@ -72,13 +82,14 @@ rmw_node_t * rmw_create_node(
 
 const rmw_guard_condition_t * rmw_node_get_graph_guard_condition(const rmw_node_t * node)
 {
-  (void)node;
   EPROS_PRINT_TRACE()
-  rmw_guard_condition_t *
-  ret = (rmw_guard_condition_t *)rmw_allocate(sizeof(rmw_guard_condition_t));
-  ret->data = NULL;
-  ret->implementation_identifier = eprosima_microxrcedds_identifier;
-  return ret;
+  if (!node || !node->data) {
+    RMW_SET_ERROR_MSG("node handle is null");
+    return NULL;
+  }
+
+  CustomNode * custom_node = (CustomNode *)node->data;
+  return &custom_node->graph_guard_condition;
 }
 
 rmw_publisher_t * rmw_create_publisher(
@@ -182,12 +193,21 @@ rmw_ret_t rmw_take_with_info(
   CustomSubscription * custom_subscription = (CustomSubscription *)subscription->data;
 
 
+  // Get the oldest sample of the history
+  ucdrBuffer micro_buffer;
+  lock_history(custom_subscription->owner_node);
+  if (!front_subscription_sample(custom_subscription, &micro_buffer)) {
+    unlock_history(custom_subscription->owner_node);
+    return RMW_RET_OK;
+  }
+
   // Extract serialiced message using typesupport
   bool deserialize_rv = custom_subscription->type_support_callbacks->cdr_deserialize(
-    &custom_subscription->micro_buffer, ros_message,
+    &micro_buffer, ros_message,
     custom_subscription->owner_node->miscellaneous_temp_buffer,
     sizeof(custom_subscription->owner_node->miscellaneous_temp_buffer));
-  custom_subscription->micro_buffer_in_use = false;
+  pop_subscription_sample(custom_subscription);
+  unlock_history(custom_subscription->owner_node);
   if (taken != NULL) {
     *taken = deserialize_rv;
   }
@@ -292,8 +312,16 @@ rmw_guard_condition_t * rmw_create_guard_condition(void)
 {
   EPROS_PRINT_TRACE()
 
-  rmw_guard_condition_t * rmw_guard_condition = (rmw_guard_condition_t *)rmw_allocate(
-    sizeof(rmw_guard_condition_t));
+  lock_memory();
+  rmw_guard_condition_t * rmw_guard_condition =
+    (rmw_guard_condition_t *)get_memory(&guard_condition_memory);
+  unlock_memory();
+  if (!rmw_guard_condition) {
+    RMW_SET_ERROR_MSG("Not available memory node");
+    return NULL;
+  }
+  rmw_guard_condition->implementation_identifier = eprosima_microxrcedds_identifier;
+  rmw_guard_condition->data = NULL;
 
   return rmw_guard_condition;
 }
@@ -302,7 +330,11 @@ rmw_ret_t rmw_destroy_guard_condition(rmw_guard_condition_t * guard_condition)
 {
   EPROS_PRINT_TRACE()
 
-  rmw_free(guard_condition);
+  if (guard_condition) {
+    lock_memory();
+    put_memory(&guard_condition_memory, guard_condition);
+    unlock_memory();
+  }
 
   return RMW_RET_OK;
 }
@@ -317,8 +349,17 @@ rmw_wait_set_t * rmw_create_wait_set(size_t max_conditions)
 {
   EPROS_PRINT_TRACE()
 
-  rmw_wait_set_t * rmw_wait_set = (rmw_wait_set_t *)rmw_allocate(
-    sizeof(rmw_wait_set_t));
+  (void)max_conditions;
+  lock_memory();
+  rmw_wait_set_t * rmw_wait_set = (rmw_wait_set_t *)get_memory(&wait_set_memory);
+  unlock_memory();
+  if (!rmw_wait_set) {
+    RMW_SET_ERROR_MSG("Not available memory node");
+    return NULL;
+  }
+  rmw_wait_set->implementation_identifier = eprosima_microxrcedds_identifier;
+  rmw_wait_set->guard_conditions = NULL;
+  rmw_wait_set->data = NULL;
 
   return rmw_wait_set;
 }
@@ -327,7 +368,11 @@ rmw_ret_t rmw_destroy_wait_set(rmw_wait_set_t * wait_set)
 {
   EPROS_PRINT_TRACE()
 
-  rmw_free(wait_set);
+  if (wait_set) {
+    lock_memory();
+    put_memory(&wait_set_memory, wait_set);
+    unlock_memory();
+  }
 
   return RMW_RET_OK;
 }
@@ -341,36 +386,51 @@ rmw_ret_t rmw_wait(
   // Wait set is not used
     (void) wait_set;
 
-  // for Subscription requests and response
-  uint16_t subscription_request[MAX_SUBSCRIPTIONS_X_NODE];
-  uint8_t subscription_status_request[MAX_SUBSCRIPTIONS_X_NODE];
-
   // Go throw all subscriptions
   CustomNode * custom_node = NULL;
-  size_t subscriber_requests_count = 0;
+  size_t request_count = 0;
+  bool data_available = false;
   if ((subscriptions != NULL) && (subscriptions->subscriber_count > 0)) {
     // Extract first session pointer
     for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
       if (subscriptions->subscribers[i] != NULL) {
         CustomSubscription * custom_subscription =
           (CustomSubscription *)subscriptions->subscribers[i];
-        custom_node = custom_subscription->owner_node;
-
+        if (custom_node == NULL) {
+          custom_node = custom_subscription->owner_node;
+          lock_session(custom_node);
+#ifndef MICRO_XRCEDDS_USE_IO_THREAD
+          // With an I/O thread liveliness is checked there
+          (void)check_agent_liveliness(custom_node);
+#endif
+          lock_history(custom_node);
+        }
 
-        if (custom_subscription->waiting_for_response == false) {
-          custom_subscription->waiting_for_response = true;
-          custom_subscription->subscription_request = uxr_buffer_request_data(&custom_node->session,
-              custom_node->reliable_output, custom_subscription->datareader_id,
-              custom_node->reliable_input,
-              NULL);
+        // Keep all subscriptions with a full history do not ask for more data
+        bool history_full =
+          (custom_subscription->history_count == custom_subscription->history_depth);
+        if ((custom_subscription->waiting_for_response == false) &&
+          ((custom_subscription->qos.history != RMW_QOS_POLICY_HISTORY_KEEP_ALL) ||
+          !history_full))
+        {
+          request_subscription_data(custom_subscription);
         }
 
+        // Queued samples do not need to wait for the agent
+        if (custom_subscription->history_count > 0) {
+          data_available = true;
+        }
 
         // Reset the request id
-        subscription_request[i] = custom_subscription->subscription_request;
+        if (request_count < custom_node->subscription_capacity) {
+          custom_node->wait_requests[request_count++] = custom_subscription->subscription_request;
+        }
       }
     }
   }
+  if (custom_node != NULL) {
+    unlock_history(custom_node);
+  }
 
   // Go throw all services
   /*
@@ -441,27 +501,41 @@ rmw_ret_t rmw_wait(
     timeout = UXR_TIMEOUT_INF;
   }
 
+  // Only flush requests and collect what is already there if samples are queued
+  if (data_available) {
+    timeout = 0;
+  }
+
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  // The I/O thread sends the requests and stores the samples
+  uxr_flash_output_streams(&custom_node->session);
+  unlock_session(custom_node);
+  wait_for_samples(custom_node, subscriptions, (int)timeout);
+#else
   // read until status or timeout
-  if (subscriptions->subscriber_count > 0) {
-    uxr_run_session_until_one_status(&custom_node->session, timeout, subscription_request,
-      subscription_status_request, subscriptions->subscriber_count);
+  if (request_count > 0) {
+    run_session_until_status(custom_node, (int)timeout, request_count);
   }
+  unlock_session(custom_node);
+#endif
 
 
   // Clean non-received
   bool is_timeout = true;
+  lock_history(custom_node);
   if (subscriptions != NULL) {
     for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
       // Check if there are any data
       CustomSubscription * custom_subscription =
         (CustomSubscription *)(subscriptions->subscribers[i]);
-      if (custom_subscription->waiting_for_response) {
+      if (custom_subscription->history_count == 0) {
         subscriptions->subscribers[i] = NULL;
       } else {
         is_timeout = false;
       }
     }
   }
+  unlock_history(custom_node);
   if (services != NULL) {
     for (size_t i = 0; i < services->service_count; ++i) {
       services->services[i] = NULL;
@@ -16,26 +16,97 @@
 
 #include <string.h>
 
-#include <rmw/allocators.h>
 #include <rmw/error_handling.h>
 
+#include "./rmw_node.h"
 #include "./utils.h"
 
 
+static uint32_t topic_hash(const char * topic_name, const char * type_name)
+{
+  // FNV-1a over the topic name and the type name
+  uint32_t hash = 2166136261u;
+  for (const char * c = topic_name; *c != '\0'; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  hash = (hash ^ '\0') * 16777619u;
+  for (const char * c = type_name; *c != '\0'; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  return hash;
+}
+
+uint16_t buffer_create_topic(custom_topic_t * custom_topic, uint8_t mode)
+{
+  CustomNode * custom_node = custom_topic->owner_node;
+  uint16_t topic_req = UXR_INVALID_REQUEST_ID;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char xml_buffer[400];
+  if (!build_topic_xml(custom_topic, xml_buffer, sizeof(xml_buffer))) {
+    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
+    return UXR_INVALID_REQUEST_ID;
+  }
+
+  topic_req = uxr_buffer_create_topic_xml(&custom_node->session,
+      custom_node->reliable_output, custom_topic->topic_id,
+      custom_node->participant_id, xml_buffer, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  char profile_name[64];
+  if (!build_topic_profile(&custom_topic->topic_name[custom_topic->ros_name_offset],
+    profile_name, sizeof(profile_name)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+    return UXR_INVALID_REQUEST_ID;
+  }
+
+  topic_req = uxr_buffer_create_topic_ref(&custom_node->session,
+      custom_node->reliable_output, custom_topic->topic_id,
+      custom_node->participant_id, profile_name, mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  topic_req = uxr_buffer_create_topic_bin(&custom_node->session,
+      custom_node->reliable_output, custom_topic->topic_id,
+      custom_node->participant_id, custom_topic->topic_name, custom_topic->type_name, mode);
+#endif
+  flush_entity_request(custom_node);
+  return topic_req;
+}
+
 custom_topic_t * create_topic(
   struct CustomNode * custom_node,
   const char * topic_name,
   const message_type_support_callbacks_t * message_type_support_callbacks,
   const rmw_qos_profile_t * qos_policies)
 {
-  // find topic in list
-  custom_topic_t * custom_topic_ptr = custom_node->custom_topic_sp;
+  // Render the topic and type names as seen by the agent
+  char full_topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 3];
+  int full_topic_name_length = generate_topic_name(topic_name, qos_policies, full_topic_name,
+      sizeof(full_topic_name));
+  char type_name[RMW_TYPE_NAME_MAX_NAME_LENGTH + 1];
+  int type_name_length = generate_type_name(message_type_support_callbacks, "msg", type_name,
+      sizeof(type_name));
+  if ((full_topic_name_length == 0) || (type_name_length == 0)) {
+    RMW_SET_ERROR_MSG("failed to generate topic or type name");
+    return NULL;
+  }
+
+  if (custom_node->topic_hash_size == 0) {
+    RMW_SET_ERROR_MSG("Not available memory node");
+    return NULL;
+  }
+
+  // find topic in the hash index
+  uint32_t hash = topic_hash(full_topic_name, type_name);
+  custom_topic_t ** bucket = &custom_node->topic_hash[hash % custom_node->topic_hash_size];
+  custom_topic_t * custom_topic_ptr = *bucket;
   while (custom_topic_ptr != NULL) {
-    if (message_type_support_callbacks == custom_topic_ptr->message_type_support_callbacks) {
+    if ((custom_topic_ptr->hash == hash) &&
+      (strcmp(full_topic_name, custom_topic_ptr->topic_name) == 0) &&
+      (strcmp(type_name, custom_topic_ptr->type_name) == 0))
+    {
       break;
     }
 
-    custom_topic_ptr = custom_topic_ptr->next_custom_topic;
+    custom_topic_ptr = custom_topic_ptr->next_in_bucket;
   }
 
   // Check if allready exists
@@ -44,10 +115,10 @@ custom_topic_t * create_topic(
     goto create_topic_end;
   }
 
-  // Generate new memory
-  custom_topic_ptr = (custom_topic_t *)rmw_allocate(sizeof(custom_topic_t));
+  // Get memory from the node pool
+  custom_topic_ptr = (custom_topic_t *)get_memory(&custom_node->topic_mem);
   if (custom_topic_ptr == NULL) {
-    RMW_SET_ERROR_MSG("failed to allocate topic interna mem");
+    RMW_SET_ERROR_MSG("Not available memory node");
     goto create_topic_end;
   }
 
@@ -57,55 +128,34 @@ custom_topic_t * create_topic(
   custom_topic_ptr->usage_account = 1;
   custom_topic_ptr->owner_node = custom_node;
 
-  // Add to top of the node stack
-  custom_topic_ptr->next_custom_topic = custom_node->custom_topic_sp;
-  if (custom_node->custom_topic_sp != NULL) {
-    custom_node->custom_topic_sp->prev_custom_topic = custom_topic_ptr;
-  }
-  custom_node->custom_topic_sp = custom_topic_ptr;
+  // Add to the hash index
+  custom_topic_ptr->hash = hash;
+  custom_topic_ptr->next_in_bucket = *bucket;
+  *bucket = custom_topic_ptr;
 
 
   // Asociate to typesupport
   custom_topic_ptr->message_type_support_callbacks = message_type_support_callbacks;
 
+  // Cache the rendered names
+  memcpy(custom_topic_ptr->topic_name, full_topic_name, (size_t)full_topic_name_length + 1);
+  custom_topic_ptr->topic_name_length = (size_t)full_topic_name_length;
+  custom_topic_ptr->ros_name_offset = (size_t)full_topic_name_length - strlen(topic_name);
+  memcpy(custom_topic_ptr->type_name, type_name, (size_t)type_name_length + 1);
+  custom_topic_ptr->type_name_length = (size_t)type_name_length;
+
 
   // Generate topic id
   custom_topic_ptr->topic_id = uxr_object_id(custom_node->id_gen++, UXR_TOPIC_ID);
 
-#ifdef MICRO_XRCEDDS_USE_XML
-  char xml_buffer[400];
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  char profile_name[64];
-#endif
-
   // Generate request
-  uint16_t topic_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  if (!build_topic_xml(topic_name, message_type_support_callbacks,
-    qos_policies, xml_buffer, sizeof(xml_buffer)))
-  {
-    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
+  uint16_t topic_req = buffer_create_topic(custom_topic_ptr, ENTITY_CREATION_MODE);
+  if (topic_req == UXR_INVALID_REQUEST_ID) {
     (void)destroy_topic(custom_topic_ptr);
     custom_topic_ptr = NULL;
     goto create_topic_end;
   }
 
-  topic_req = uxr_buffer_create_topic_xml(&custom_node->session,
-      custom_node->reliable_output, custom_topic_ptr->topic_id,
-      custom_node->participant_id, xml_buffer, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  if (!build_topic_profile(topic_name, profile_name, sizeof(profile_name))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
-    (void)destroy_topic(custom_topic_ptr);
-    custom_topic_ptr = NULL;
-    goto create_topic_end;
-  }
-
-  topic_req = uxr_buffer_create_topic_ref(&custom_node->session,
-      custom_node->reliable_output, custom_topic_ptr->topic_id,
-      custom_node->participant_id, profile_name, UXR_REPLACE);
-#endif
-
   // Send the request and wait for response
   uint8_t status;
   custom_topic_ptr->sync_with_agent =
@@ -131,22 +181,26 @@ bool destroy_topic(custom_topic_t * custom_topic)
   if (custom_topic != NULL) {
     custom_topic->usage_account--;
     if (custom_topic->usage_account <= 0) {
-      // Remove from the stack
-      if (custom_topic->next_custom_topic != NULL) {
-        custom_topic->next_custom_topic->prev_custom_topic = custom_topic->prev_custom_topic;
-      }
-      if (custom_topic->prev_custom_topic != NULL) {
-        custom_topic->prev_custom_topic->next_custom_topic = custom_topic->next_custom_topic;
-      } else {
-        custom_topic->owner_node->custom_topic_sp = NULL;
+      CustomNode * custom_node = custom_topic->owner_node;
+
+      // Remove from the hash index
+      custom_topic_t ** link =
+        &custom_node->topic_hash[custom_topic->hash % custom_node->topic_hash_size];
+      while (*link != NULL) {
+        if (*link == custom_topic) {
+          *link = custom_topic->next_in_bucket;
+          break;
+        }
+        link = &(*link)->next_in_bucket;
       }
+      custom_topic->next_in_bucket = NULL;
 
       if (custom_topic->sync_with_agent) {
-        uint16_t request = uxr_buffer_delete_entity(&custom_topic->owner_node->session,
-            custom_topic->owner_node->reliable_output,
+        uint16_t request = uxr_buffer_delete_entity(&custom_node->session,
+            custom_node->reliable_output,
             custom_topic->topic_id);
         uint8_t status;
-        if (!uxr_run_session_until_all_status(&custom_topic->owner_node->session, 1000,
+        if (!uxr_run_session_until_all_status(&custom_node->session, 1000,
           &request, &status, 1))
         {
           RMW_SET_ERROR_MSG("unable to remove publisher from the server");
@@ -157,7 +211,7 @@ bool destroy_topic(custom_topic_t * custom_topic)
         ok = true;
       }
 
-      rmw_free(custom_topic);
+      put_memory(&custom_node->topic_mem, custom_topic);
     } else {
       ok = true;
     }
@@ -169,12 +223,5 @@ bool destroy_topic(custom_topic_t * custom_topic)
 
 size_t topic_count(struct CustomNode * custom_node)
 {
-  size_t count = 0;
-  custom_topic_t * custom_topic_ptr = custom_node->custom_topic_sp;
-  while (custom_topic_ptr != NULL) {
-    count++;
-    custom_topic_ptr = custom_topic_ptr->next_custom_topic;
-  }
-
-  return count;
+  return custom_node->topic_mem.in_use;
 }
@@ -34,6 +34,9 @@ custom_topic_t * create_topic(
 
 bool destroy_topic(custom_topic_t * custom_topic);
 
+// Buffers the topic creation request, returns UXR_INVALID_REQUEST_ID on failure.
+uint16_t buffer_create_topic(custom_topic_t * custom_topic, uint8_t mode);
+
 size_t topic_count(struct CustomNode * custom_node);
 
 #if defined(__cplusplus)
@@ -14,31 +14,312 @@
 
 #include "./rmw_node.h"  // NOLINT
 
-#ifdef MICRO_XRCEDDS_SERIAL
-#include <fcntl.h>  // O_RDWR, O_NOCTTY, O_NONBLOCK
-#include <termios.h>
-#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include <rmw/allocators.h>
 #include <rmw/error_handling.h>
 #include <rmw/rmw.h>
 
+#include "./agent_list.h"
+#include "./io_thread.h"
+#include "./liveliness.h"
+#include "./rmw_subscriber.h"
+#include "./transport.h"
 #include "./types.h"
 #include "./utils.h"
 
 
-#ifdef MICRO_XRCEDDS_SERIAL
-#define CLOSE_TRANSPORT(transport) uxr_close_serial_transport(transport)
-#elif defined(MICRO_XRCEDDS_UDP)
-#define CLOSE_TRANSPORT(transport) uxr_close_udp_transport(transport)
-#endif
+#define DEFAULT_LIMITS {MAX_NODES, MAX_PUBLISHERS_X_NODE, MAX_SUBSCRIPTIONS_X_NODE, \
+                        MAX_TOPICS_X_NODE, MAX_HISTORY_X_SUBSCRIPTION, MAX_HISTORY}
 
 static struct MemPool node_memory;
-static CustomNode custom_nodes[MAX_NODES];
+static rmw_uxrce_limits_t node_limits = DEFAULT_LIMITS;
+static rmw_uxrce_limits_t requested_limits;
+static bool limits_requested = false;
+static uint32_t session_key_state;
+
+#ifdef MICRO_XRCEDDS_USE_ARENA
+static uint8_t * node_arena = NULL;
+static size_t node_arena_size = 0;
+#else
+// Upper bound of nodes_memory_size() for the configured maximums.
+#define ARENA_REGION(size) ((size) + ARENA_ALIGNMENT)
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+#define IO_QUEUE_STORAGE_SIZE ARENA_REGION(IO_QUEUE_SIZE * sizeof(IoQueueCell))
+#else
+#define IO_QUEUE_STORAGE_SIZE 0
+#endif
+#define NODE_STORAGE_SIZE \
+  (ARENA_REGION(MAX_PUBLISHERS_X_NODE * sizeof(CustomPublisher)) + \
+  ARENA_REGION(MAX_PUBLISHERS_X_NODE * sizeof(struct MemLink)) + \
+  ARENA_REGION(MAX_SUBSCRIPTIONS_X_NODE * sizeof(CustomSubscription)) + \
+  ARENA_REGION(MAX_SUBSCRIPTIONS_X_NODE * sizeof(struct MemLink)) + \
+  ARENA_REGION(MAX_TOPICS_X_NODE * sizeof(custom_topic_t)) + \
+  ARENA_REGION(MAX_TOPICS_X_NODE * sizeof(struct MemLink)) + \
+  ARENA_REGION(2 * MAX_TOPICS_X_NODE * sizeof(custom_topic_t *)) + \
+  ARENA_REGION(MAX_SUBSCRIPTIONS_X_NODE * sizeof(uint16_t)) + \
+  ARENA_REGION(MAX_SUBSCRIPTIONS_X_NODE * sizeof(uint8_t)) + \
+  2 * ARENA_REGION(MAX_BUFFER_SIZE) + \
+  MAX_SUBSCRIPTIONS_X_NODE * \
+  (ARENA_REGION(MAX_HISTORY_X_SUBSCRIPTION * MAX_TRANSPORT_MTU) + \
+  ARENA_REGION(MAX_HISTORY_X_SUBSCRIPTION * sizeof(size_t))) + \
+  IO_QUEUE_STORAGE_SIZE)
+#define NODE_ARENA_SIZE \
+  (ARENA_ALIGNMENT + ARENA_REGION(MAX_NODES * sizeof(CustomNode)) + \
+  ARENA_REGION(MAX_NODES * sizeof(struct MemLink)) + MAX_NODES * NODE_STORAGE_SIZE)
+
+static uint8_t node_arena[NODE_ARENA_SIZE];
+static const size_t node_arena_size = NODE_ARENA_SIZE;
+#endif
+
+static bool read_limit_env(const char * name, size_t * limit)
+{
+  const char * value = getenv(name);
+  if ((value == NULL) || (value[0] == '\0')) {
+    return true;
+  }
+
+  char * end = NULL;
+  unsigned long parsed = strtoul(value, &end, 10);  // NOLINT
+  if (*end != '\0') {
+    RMW_SET_ERROR_MSG("invalid RMW_UXRCE_MAX_* environment variable");
+    return false;
+  }
+  *limit = (size_t)parsed;
+  return true;
+}
+
+static bool check_limit(size_t limit, size_t minimum, size_t maximum)
+{
+  return (limit >= minimum) && (limit <= maximum);
+}
+
+static bool check_limits(const rmw_uxrce_limits_t * limits)
+{
+#ifdef MICRO_XRCEDDS_USE_ARENA
+  // Keeps pool indexes and request sample counts within 16 bits.
+  const rmw_uxrce_limits_t maximum = {MEM_POOL_MAX_CAPACITY, MEM_POOL_MAX_CAPACITY,
+    MEM_POOL_MAX_CAPACITY, MEM_POOL_MAX_CAPACITY, UINT16_MAX, UINT16_MAX};
+#else
+  const rmw_uxrce_limits_t maximum = DEFAULT_LIMITS;
+#endif
+  return check_limit(limits->max_nodes, 1, maximum.max_nodes) &&
+         check_limit(limits->max_publishers_x_node, 0, maximum.max_publishers_x_node) &&
+         check_limit(limits->max_subscriptions_x_node, 0, maximum.max_subscriptions_x_node) &&
+         check_limit(limits->max_topics_x_node, 0, maximum.max_topics_x_node) &&
+         check_limit(limits->max_history_x_subscription, 1,
+           maximum.max_history_x_subscription) &&
+         check_limit(limits->max_history, 1, maximum.max_history);
+}
+
+rmw_ret_t rmw_uxrce_set_limits(const rmw_uxrce_limits_t * limits)
+{
+  if (!limits) {
+    RMW_SET_ERROR_MSG("limits is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!check_limits(limits)) {
+    RMW_SET_ERROR_MSG("limits out of range");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  requested_limits = *limits;
+  limits_requested = true;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_get_limits(rmw_uxrce_limits_t * limits)
+{
+  if (!limits) {
+    RMW_SET_ERROR_MSG("limits is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  *limits = node_limits;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_get_memory_stats(rmw_uxrce_memory_stats_t * stats)
+{
+  if (!stats) {
+    RMW_SET_ERROR_MSG("stats is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  memset(stats, 0, sizeof(rmw_uxrce_memory_stats_t));
+  stats->nodes_in_use = node_memory.in_use;
+  stats->nodes_high_water = node_memory.high_water;
+
+  // Never used nodes have empty statistics, so looking at all of them is fine.
+  CustomNode * nodes = (CustomNode *)(void *)node_memory.slab;
+  for (size_t i = 0; i < node_memory.capacity; i++) {
+    if (nodes[i].publisher_mem.high_water > stats->publishers_x_node_high_water) {
+      stats->publishers_x_node_high_water = nodes[i].publisher_mem.high_water;
+    }
+    if (nodes[i].subscription_mem.high_water > stats->subscriptions_x_node_high_water) {
+      stats->subscriptions_x_node_high_water = nodes[i].subscription_mem.high_water;
+    }
+    if (nodes[i].topic_mem.high_water > stats->topics_x_node_high_water) {
+      stats->topics_x_node_high_water = nodes[i].topic_mem.high_water;
+    }
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_get_footprint(
+  const rmw_uxrce_limits_t * limits,
+  rmw_uxrce_footprint_t * footprint)
+{
+  if (!footprint) {
+    RMW_SET_ERROR_MSG("footprint is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!limits) {
+    limits = &node_limits;
+  } else if (!check_limits(limits)) {
+    RMW_SET_ERROR_MSG("limits out of range");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  nodes_memory_footprint(limits, footprint);
+#ifndef MICRO_XRCEDDS_USE_ARENA
+  // The static arena is reserved for the configured maximums whatever the limits in use.
+  footprint->node_arena = node_arena_size;
+#endif
+  footprint->guard_condition = sizeof(rmw_guard_condition_t) + sizeof(struct MemLink);
+  footprint->wait_set = sizeof(rmw_wait_set_t) + sizeof(struct MemLink);
+  footprint->total = footprint->node_arena +
+    MAX_GUARD_CONDITIONS * footprint->guard_condition +
+    MAX_WAIT_SETS * footprint->wait_set;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t init_rmw_node()
+{
+  rmw_uxrce_limits_t limits = DEFAULT_LIMITS;
+  if (limits_requested) {
+    limits = requested_limits;
+  } else if (!read_limit_env("RMW_UXRCE_MAX_NODES", &limits.max_nodes) ||  // NOLINT
+    !read_limit_env("RMW_UXRCE_MAX_PUBLISHERS_X_NODE", &limits.max_publishers_x_node) ||
+    !read_limit_env("RMW_UXRCE_MAX_SUBSCRIPTIONS_X_NODE", &limits.max_subscriptions_x_node) ||
+    !read_limit_env("RMW_UXRCE_MAX_TOPICS_X_NODE", &limits.max_topics_x_node) ||
+    !read_limit_env("RMW_UXRCE_MAX_HISTORY_X_SUBSCRIPTION",
+    &limits.max_history_x_subscription) ||
+    !read_limit_env("RMW_UXRCE_MAX_HISTORY", &limits.max_history))
+  {
+    return RMW_RET_ERROR;
+  }
+
+  if (!check_limits(&limits)) {
+    RMW_SET_ERROR_MSG("RMW_UXRCE_MAX_* environment variable out of range");
+    return RMW_RET_ERROR;
+  }
+
+  rmw_ret_t ret = init_transport_params();
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  ret = init_agent_list();
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+
+#ifdef MICRO_XRCEDDS_USE_ARENA
+  size_t arena_size = nodes_memory_size(&limits);
+  // Every pool comes from this single allocation, a later rmw_init reuses it if it fits.
+  if (arena_size > node_arena_size) {
+    rmw_free(node_arena);
+    node_arena_size = 0;
+    node_arena = (uint8_t *)rmw_allocate(arena_size);
+    if (!node_arena) {
+      RMW_SET_ERROR_MSG("failed to allocate node arena");
+      return RMW_RET_BAD_ALLOC;
+    }
+    node_arena_size = arena_size;
+  }
+#endif
+
+  if (!init_nodes_memory(&node_memory, node_arena, node_arena_size, &limits)) {
+    RMW_SET_ERROR_MSG("node arena too small");
+    return RMW_RET_ERROR;
+  }
+  node_limits = limits;
+#ifdef MICRO_XRCEDDS_SESSION_REUSE
+  // Salt of the stable keys, tells apart devices running the same nodes on one agent
+  const char * client_key = getenv("RMW_UXRCE_CLIENT_KEY");
+  session_key_state = 0;
+  if ((client_key != NULL) && (client_key[0] != '\0')) {
+    char * end = NULL;
+    session_key_state = (uint32_t)strtoul(client_key, &end, 0);
+    if (*end != '\0') {
+      RMW_SET_ERROR_MSG("invalid RMW_UXRCE_CLIENT_KEY environment variable");
+      return RMW_RET_ERROR;
+    }
+  }
+#else
+  session_key_state = (uint32_t)time(NULL) ^ (uint32_t)(uintptr_t)&node_memory;
+#endif
+  return RMW_RET_OK;
+}
+
+static uint32_t mix_session_key(uint32_t key)
+{
+  key = (key ^ (key >> 16)) * 0x85EBCA6Bu;
+  key = (key ^ (key >> 13)) * 0xC2B2AE35u;
+  return key ^ (key >> 16);
+}
+
+#ifdef MICRO_XRCEDDS_SESSION_REUSE
+static uint32_t hash_name(uint32_t hash, const char * name)
+{
+  // FNV-1a
+  for (; *name != '\0'; name++) {
+    hash = (hash ^ (uint8_t)*name) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t stable_session_key(const char * name, const char * namespace_, size_t domain_id)
+{
+  // Same node, same key across runs, so the agent session and its entities are reused
+  uint32_t hash = hash_name(2166136261u, namespace_);
+  hash = hash_name((hash ^ '/') * 16777619u, name);
+  hash = (hash ^ (uint32_t)domain_id) * 16777619u;
+  return mix_session_key(hash ^ session_key_state);
+}
+
+// ROS allows duplicate node names, and a second session with the same key would take
+// the first one over on the agent. Duplicates get the next keys of a fixed sequence, so
+// they keep their sessions across runs too. Called with the memory lock held.
+static uint32_t unique_session_key(const CustomNode * node, uint32_t key)
+{
+  CustomNode * other = (CustomNode *)first_allocated(&node_memory);
+  while (other != NULL) {
+    if ((other != node) && (other->session_key == key)) {
+      key = mix_session_key(key + 0x9E3779B9u);
+      other = (CustomNode *)first_allocated(&node_memory);
+    } else {
+      other = (CustomNode *)next_allocated(&node_memory, other);
+    }
+  }
+  return key;
+}
+#else
+static uint32_t next_session_key(void)
+{
+  // Scrambled counter, keys are unique within the process and differ between runs
+  session_key_state += 0x9E3779B9u;
+  return mix_session_key(session_key_state);
+}
+#endif
 
-void init_rmw_node()
+static void release_node(CustomNode * node)
 {
-  init_nodes_memory(&node_memory, custom_nodes, MAX_NODES);
+  lock_memory();
+  put_memory(&node_memory, node);
+  unlock_memory();
 }
 
 void on_status(
@@ -64,16 +345,14 @@ void on_topic(
   CustomNode * node = (CustomNode *)args;
 
   // Search subscription
-  struct Item * subscription_item = node->subscription_mem.allocateditems;
-  CustomSubscription * custom_subscription = NULL;
+  CustomSubscription * custom_subscription = first_allocated(&node->subscription_mem);
   while (true) {
     // Check if end of stack
-    if (subscription_item == NULL) {
+    if (custom_subscription == NULL) {
       return;
     }
 
     // Compare id
-    custom_subscription = (CustomSubscription *)subscription_item->data;
     if ((custom_subscription->datareader_id.id == object_id.id) &&
       (custom_subscription->datareader_id.type == object_id.type))
     {
@@ -81,198 +360,265 @@ void on_topic(
     }
 
     // Next subscription of the stack
-    subscription_item = subscription_item->next;
+    custom_subscription = next_allocated(&node->subscription_mem, custom_subscription);
+  }
+
+  // The request is over once all requested samples have been delivered
+  if (custom_subscription->requested_samples > 0) {
+    custom_subscription->requested_samples--;
+  }
+  if (custom_subscription->requested_samples == 0) {
+    custom_subscription->waiting_for_response = false;
   }
 
-  // Check if temporal micro buffer is on use
-  if (custom_subscription->micro_buffer_in_use) {
-    RMW_SET_ERROR_MSG("Internal memory error");
+  // Copy sample data into the subscription history
+  lock_history(node);
+  if (push_subscription_sample(custom_subscription, serialization)) {
+    node->on_subscription = true;
+    notify_samples(node);
+  }
+  unlock_history(node);
+}
+
+void init_node_session(CustomNode * node)
+{
+  uxr_init_session(&node->session, node->comm, node->session_key);
+  uxr_set_topic_callback(&node->session, on_topic, node);
+  uxr_set_status_callback(&node->session, on_status, NULL);
+
+#ifdef MICRO_XRCEDDS_TCP
+  // XRCE reliability on top of TCP would only duplicate its retransmissions
+  if (node->transport_kind == RMW_UXRCE_TRANSPORT_TCP) {
+    node->reliable_input = uxr_create_input_best_effort_stream(&node->session);
+    node->reliable_output = uxr_create_output_best_effort_stream(&node->session,
+        node->output_reliable_stream_buffer, node->comm->mtu);
     return;
   }
+#endif
+
+  node->reliable_input = uxr_create_input_reliable_stream(
+    &node->session, node->input_reliable_stream_buffer,
+    node->comm->mtu * node->stream_history,
+    (uint16_t)node->stream_history);
+  node->reliable_output =
+    uxr_create_output_reliable_stream(&node->session, node->output_reliable_stream_buffer,
+      node->comm->mtu * node->stream_history,
+      (uint16_t)node->stream_history);
+}
+
+void flush_entity_request(CustomNode * node)
+{
+#ifdef MICRO_XRCEDDS_TCP
+  if (node->transport_kind == RMW_UXRCE_TRANSPORT_TCP) {
+    uxr_flash_output_streams(&node->session);
+  }
+#else
+  (void)node;
+#endif
+}
+
+uint16_t buffer_create_participant(CustomNode * node, uint8_t mode)
+{
+  uint16_t participant_req = UXR_INVALID_REQUEST_ID;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char participant_xml[300];
+  if (!build_participant_xml(node->domain_id, node->name, participant_xml,
+    sizeof(participant_xml)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+    return UXR_INVALID_REQUEST_ID;
+  }
+  participant_req =
+    uxr_buffer_create_participant_xml(&node->session, node->reliable_output,
+      node->participant_id, (int16_t)node->domain_id, participant_xml, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  char profile_name[20];
+  if (!build_participant_profile(profile_name, sizeof(profile_name))) {
+    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+    return UXR_INVALID_REQUEST_ID;
+  }
+  participant_req = uxr_buffer_create_participant_ref(&node->session,
+      node->reliable_output,
+      node->participant_id, (int16_t)node->domain_id, profile_name, mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  participant_req = uxr_buffer_create_participant_bin(&node->session,
+      node->reliable_output,
+      node->participant_id, (int16_t)node->domain_id, node->name, mode);
+#endif
+  flush_entity_request(node);
+  return participant_req;
+}
+
+// Opens the transport and creates the session, on the first agent of the list that
+// answers when the list applies to the transport kind.
+static bool connect_node_session(CustomNode * node, const rmw_uxrce_transport_params_t * params)
+{
+  node->agent_index = NO_AGENT;
+  if (!agent_list_applies(params->kind)) {
+    if (!open_node_transport(node, params)) {
+      return false;
+    }
+    init_node_session(node);
+    if (!uxr_create_session(&node->session)) {
+      close_node_transport(node);
+      RMW_SET_ERROR_MSG("failed to create node session on Micro ROS Agent.");
+      return false;
+    }
+    return true;
+  }
+
+  size_t order[MAX_AGENTS];
+  size_t candidate_count = agent_candidates(order);
+  rmw_uxrce_transport_params_t agent_params = *params;
+  agent_params.agent_discovery = false;
+  for (size_t i = 0; i < candidate_count; i++) {
+    get_agent_endpoint(order[i], &agent_params);
+    if (open_node_transport(node, &agent_params)) {
+      init_node_session(node);
+      if (uxr_create_session(&node->session)) {
+        node->agent_index = order[i];
+        agent_connected(order[i]);
+        return true;
+      }
+      close_node_transport(node);
+    }
+    agent_failed(order[i]);
+  }
+  RMW_SET_ERROR_MSG("failed to create node session on any agent of the list.");
+  return false;
+}
 
-  // not waiting for response any more
-  custom_subscription->waiting_for_response = false;
-  node->on_subscription = true;
+static void disconnect_node(CustomNode * node)
+{
+  close_node_transport(node);
+  if (node->agent_index != NO_AGENT) {
+    agent_disconnected(node->agent_index);
+    node->agent_index = NO_AGENT;
+  }
+}
 
+bool failover_node_session(CustomNode * node)
+{
+  if (!agent_list_applies(node->transport_kind)) {
+    return false;
+  }
+  if (node->agent_index != NO_AGENT) {
+    agent_failed(node->agent_index);
+  }
+  disconnect_node(node);
+
+  // Only the best candidate is tried, liveliness checks move on to the next ones
+  size_t order[MAX_AGENTS];
+  if (agent_candidates(order) > 0) {
+    rmw_uxrce_transport_params_t transport_params;
+    get_transport_params(&transport_params);
+    transport_params.kind = node->transport_kind;
+    transport_params.agent_discovery = false;
+    get_agent_endpoint(order[0], &transport_params);
+    if (open_node_transport(node, &transport_params)) {
+      init_node_session(node);
+      if (uxr_create_session_retries(&node->session, RECOVERY_ATTEMPTS)) {
+        node->agent_index = order[0];
+        agent_connected(order[0]);
+        return true;
+      }
+      close_node_transport(node);
+    }
+    agent_failed(order[0]);
+  }
 
-  // Copy microbuffer data
-  memcpy(&custom_subscription->micro_buffer, serialization,
-    sizeof(custom_subscription->micro_buffer));
-  custom_subscription->micro_buffer_in_use = true;
+  open_disconnected_transport(node);
+  init_node_session(node);
+  return false;
 }
 
 void clear_node(rmw_node_t * node)
 {
   CustomNode * micro_node = (CustomNode *)node->data;
+  stop_node_io(micro_node);
+#ifndef MICRO_XRCEDDS_SESSION_REUSE
   // TODO(Borja) make sure that session deletion deletes participant and related entities.
   uxr_delete_session(&micro_node->session);
-  CLOSE_TRANSPORT(&micro_node->transport);
+#else
+  // The agent keeps the session and its entities for the next run of this node
+  uxr_flash_output_streams(&micro_node->session);
+#endif
+  disconnect_node(micro_node);
   rmw_node_delete(node);
 
-  put_memory(&node_memory, &micro_node->mem);
+  release_node(micro_node);
 }
 
 rmw_node_t * create_node(const char * name, const char * namespace_, size_t domain_id)
 {
-  // TODO(Javier) Need to be changed into a to thread-save code.
-  //  The suggested option rand_r() is not valid for this purpose.
-  //  This change is pending to new feature in Micro XRCE-DDS that will provide an unused ID.
-  //  When removed, the random initalization code in rmw_inint() must be removed.
-  uint32_t key = rand();  // NOLINT
-
-  struct Item * memory_node = get_memory(&node_memory);
-  if (!memory_node) {
-    RMW_SET_ERROR_MSG("Not available memory node");
+  if ((strlen(name) > RMW_NODE_NAME_MAX_NAME_LENGTH) ||
+    (strlen(namespace_) > RMW_NODE_NAME_MAX_NAME_LENGTH))
+  {
+    RMW_SET_ERROR_MSG("node name or namespace too long");
     return NULL;
   }
 
-  CustomNode * node_info = (CustomNode *)memory_node->data;
-
-#ifdef MICRO_XRCEDDS_SERIAL
-  int fd = open(SERIAL_DEVICE, O_RDWR | O_NOCTTY);
-  if (0 < fd) {
-    struct termios tty_config;
-    memset(&tty_config, 0, sizeof(tty_config));
-    if (0 == tcgetattr(fd, &tty_config)) {
-      /* Setting CONTROL OPTIONS. */
-      tty_config.c_cflag |= CREAD;          // Enable read.
-      tty_config.c_cflag |= CLOCAL;         // Set local mode.
-      tty_config.c_cflag &= ~PARENB;        // Disable parity.
-      tty_config.c_cflag &= ~CSTOPB;        // Set one stop bit.
-      tty_config.c_cflag &= ~CSIZE;         // Mask the character size bits.
-      tty_config.c_cflag |= CS8;            // Set 8 data bits.
-      tty_config.c_cflag &= ~CRTSCTS;       // Disable hardware flow control.
-
-      /* Setting LOCAL OPTIONS. */
-      tty_config.c_lflag &= ~ICANON;        // Set non-canonical input.
-      tty_config.c_lflag &= ~ECHO;          // Disable echoing of input characters.
-      tty_config.c_lflag &= ~ECHOE;         // Disable echoing the erase character.
-      tty_config.c_lflag &= ~ISIG;          // Disable SIGINTR, SIGSUSP, SIGDSUSP
-                                            // and SIGQUIT signals.
-
-      /* Setting INPUT OPTIONS. */
-      tty_config.c_iflag &= ~IXON;          // Disable output software flow control.
-      tty_config.c_iflag &= ~IXOFF;         // Disable input software flow control.
-      tty_config.c_iflag &= ~INPCK;         // Disable parity check.
-      tty_config.c_iflag &= ~ISTRIP;        // Disable strip parity bits.
-      tty_config.c_iflag &= ~IGNBRK;        // No ignore break condition.
-      tty_config.c_iflag &= ~IGNCR;         // No ignore carrier return.
-      tty_config.c_iflag &= ~INLCR;         // No map NL to CR.
-      tty_config.c_iflag &= ~ICRNL;         // No map CR to NL.
-
-      /* Setting OUTPUT OPTIONS. */
-      tty_config.c_oflag &= ~OPOST;         // Set raw output.
-
-      /* Setting OUTPUT CHARACTERS. */
-      tty_config.c_cc[VMIN] = 34;
-      tty_config.c_cc[VTIME] = 10;
-
-      /* Setting BAUD RATE. */
-      cfsetispeed(&tty_config, B115200);
-      cfsetospeed(&tty_config, B115200);
-
-      if (0 == tcsetattr(fd, TCSANOW, &tty_config)) {
-        if (!uxr_init_serial_transport(&node_info->transport,
-          &node_info->serial_platform, fd, 0, 1))
-        {
-          RMW_SET_ERROR_MSG("Can not create an serial connection");
-          return NULL;
-        }
-      }
-    }
-  }
-  printf("Serial mode => dev: %s\n", SERIAL_DEVICE);
-
-#elif defined(MICRO_XRCEDDS_UDP)
-  // TODO(Borja) Think how we are going to select transport to use
-  if (!uxr_init_udp_transport(&node_info->transport, &node_info->udp_platform, UDP_IP, UDP_PORT)) {
-    RMW_SET_ERROR_MSG("Can not create an udp connection");
-    return NULL;
-  }
-  printf("UDP mode => ip: %s - port: %hu\n", UDP_IP, UDP_PORT);
+  lock_memory();
+  CustomNode * node_info = (CustomNode *)get_memory(&node_memory);
+  if (node_info) {
+#ifdef MICRO_XRCEDDS_SESSION_REUSE
+    node_info->session_key =
+      unique_session_key(node_info, stable_session_key(name, namespace_, domain_id));
+#else
+    node_info->session_key = next_session_key();
 #endif
-
-  uxr_init_session(&node_info->session, &node_info->transport.comm, key);
-  uxr_set_topic_callback(&node_info->session, on_topic, node_info);
-  uxr_set_status_callback(&node_info->session, on_status, NULL);
-
-  node_info->reliable_input = uxr_create_input_reliable_stream(
-    &node_info->session, node_info->input_reliable_stream_buffer,
-    node_info->transport.comm.mtu * MAX_HISTORY, MAX_HISTORY);
-  node_info->reliable_output =
-    uxr_create_output_reliable_stream(&node_info->session, node_info->output_reliable_stream_buffer,
-      node_info->transport.comm.mtu * MAX_HISTORY, MAX_HISTORY);
-
-  rmw_node_t * node_handle = NULL;
-  node_handle = rmw_node_allocate();
-  if (!node_handle) {
-    RMW_SET_ERROR_MSG("failed to allocate rmw_node_t");
-    return NULL;
   }
-  node_handle->implementation_identifier = rmw_get_implementation_identifier();
-  node_handle->data = node_info;
-  node_handle->name = (const char *)(rmw_allocate(sizeof(char) * strlen(name) + 1));
-  if (!node_handle->name) {
-    RMW_SET_ERROR_MSG("failed to allocate memory");
-    CLOSE_TRANSPORT(&node_info->transport);
-    rmw_node_delete(node_handle);
+  unlock_memory();
+  if (!node_info) {
+    RMW_SET_ERROR_MSG("Not available memory node");
     return NULL;
   }
-  memcpy((char *)node_handle->name, name, strlen(name) + 1);
 
-  node_handle->namespace_ = rmw_allocate(sizeof(char) * strlen(namespace_) + 1);
-  if (!node_handle->namespace_) {
-    RMW_SET_ERROR_MSG("failed to allocate memory");
-    CLOSE_TRANSPORT(&node_info->transport);
-    rmw_node_delete(node_handle);
+  node_info->domain_id = domain_id;
+  rmw_uxrce_transport_params_t transport_params;
+  get_transport_params(&transport_params);
+  if (!connect_node_session(node_info, &transport_params)) {
+    release_node(node_info);
     return NULL;
   }
-  memcpy((char *)node_handle->namespace_, namespace_, strlen(namespace_) + 1);
 
-  if (!uxr_create_session(&node_info->session)) {
-    CLOSE_TRANSPORT(&node_info->transport);
-    rmw_node_delete(node_handle);
-    RMW_SET_ERROR_MSG("failed to create node session on Micro ROS Agent.");
-    return NULL;
-  }
+  // The handle, its strings and the graph guard condition live in the pooled node
+  memcpy(node_info->name, name, strlen(name) + 1);
+  memcpy(node_info->namespace_, namespace_, strlen(namespace_) + 1);
+  node_info->graph_guard_condition.implementation_identifier = rmw_get_implementation_identifier();
+  node_info->graph_guard_condition.data = NULL;
+
+  rmw_node_t * node_handle = &node_info->rmw_handle;
+  node_handle->implementation_identifier = rmw_get_implementation_identifier();
+  node_handle->data = node_info;
+  node_handle->name = node_info->name;
+  node_handle->namespace_ = node_info->namespace_;
 
   // Create the Node participant. At this point a Node correspond with
   // a Session with one participant.
   node_info->participant_id = uxr_object_id(node_info->id_gen++, UXR_PARTICIPANT_ID);
-  uint16_t participant_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  char participant_xml[300];
-  if (!build_participant_xml(domain_id, name, participant_xml, sizeof(participant_xml))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
-    return NULL;
-  }
-  participant_req =
-    uxr_buffer_create_participant_xml(&node_info->session, node_info->reliable_output,
-      node_info->participant_id,
-      domain_id, participant_xml, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  char profile_name[20];
-  if (!build_participant_profile(profile_name, sizeof(profile_name))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+  uint16_t participant_req = buffer_create_participant(node_info, ENTITY_CREATION_MODE);
+  if (participant_req == UXR_INVALID_REQUEST_ID) {
+    clear_node(node_handle);
     return NULL;
   }
-  participant_req = uxr_buffer_create_participant_ref(&node_info->session,
-      node_info->reliable_output,
-      node_info->participant_id, domain_id, profile_name, UXR_REPLACE);
-#endif
   uint8_t status[1];
   uint16_t requests[] = {participant_req};
 
   if (!uxr_run_session_until_all_status(&node_info->session, 1000, requests, status, 1)) {
-    uxr_delete_session(&node_info->session);
-    CLOSE_TRANSPORT(&node_info->transport);
-    rmw_node_delete(node_handle);
+    clear_node(node_handle);
     RMW_SET_ERROR_MSG("Issues creating micro XRCE-DDS entities");
     return NULL;
   }
 
   // TODO(Borja) create utils methods to handle publishers array.
   customnode_clear(node_info);
+  init_agent_liveliness(node_info);
+
+  if (!start_node_io(node_info)) {
+    clear_node(node_handle);
+    return NULL;
+  }
 
   return node_handle;
 }
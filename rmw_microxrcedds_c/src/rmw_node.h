@@ -21,6 +21,18 @@
 
 
 rmw_node_t * create_node(const char * name, const char * namespace_, size_t domain_id);
-void init_rmw_node();
+rmw_ret_t init_rmw_node();
+
+void init_node_session(CustomNode * node);
+// Moves the node session to the best agent of the list after its agent stopped
+// answering, with RECOVERY_ATTEMPTS session creation attempts. Returns false when the
+// list does not apply or the agent did not answer, the node is then left on a
+// disconnected transport.
+bool failover_node_session(CustomNode * node);
+// TCP nodes buffer requests on a best effort stream of a single MTU, so each creation
+// request is sent before the next one is buffered. A no-op on reliable streams.
+void flush_entity_request(CustomNode * node);
+// Buffers the participant creation request, returns UXR_INVALID_REQUEST_ID on failure.
+uint16_t buffer_create_participant(CustomNode * node, uint8_t mode);
 
 #endif  // RMW_NODE_H_
@@ -20,39 +20,121 @@
 #include <rosidl_typesupport_microxrcedds_shared/identifier.h>
 #include <rosidl_typesupport_microxrcedds_shared/message_type_support.h>
 
+#include "./io_thread.h"
+#include "./liveliness.h"
 #include "./rmw_microxrcedds.h"
 #include "./rmw_node.h"
 #include "./types.h"
 #include "./utils.h"
 #include "./rmw_microxrcedds_topic.h"
 
+bool buffer_create_publisher(
+  CustomPublisher * custom_publisher, uint8_t mode,
+  uint16_t requests[2])
+{
+  CustomNode * custom_node = custom_publisher->owner_node;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char xml_buffer[512];
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  char profile_name[96];
+#endif
+
+  uint16_t publisher_req;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char publisher_name[20];
+  generate_name(&custom_publisher->publisher_id, publisher_name, sizeof(publisher_name));
+  if (!build_publisher_xml(publisher_name, xml_buffer, sizeof(xml_buffer))) {
+    RMW_SET_ERROR_MSG("failed to generate xml request for publisher creation");
+    return false;
+  }
+  publisher_req = uxr_buffer_create_publisher_xml(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->publisher_id,
+      custom_node->participant_id, xml_buffer, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  // TODO(BORJA) Publisher by reference does not make sense
+  //             in current micro XRCE-DDS implementation.
+  publisher_req = uxr_buffer_create_publisher_xml(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->publisher_id,
+      custom_node->participant_id, "", mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  publisher_req = uxr_buffer_create_publisher_bin(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->publisher_id,
+      custom_node->participant_id, mode);
+#endif
+  flush_entity_request(custom_node);
+
+  uint16_t datawriter_req;
+#ifdef MICRO_XRCEDDS_USE_XML
+  if (!build_datawriter_xml(custom_publisher->topic, &custom_publisher->qos, xml_buffer,
+    sizeof(xml_buffer)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for publisher creation");
+    return false;
+  }
+
+  datawriter_req = uxr_buffer_create_datawriter_xml(
+    custom_publisher->session, custom_node->reliable_output, custom_publisher->datawriter_id,
+    custom_publisher->publisher_id, xml_buffer, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  if (!build_datawriter_profile(custom_publisher->topic_name, &custom_publisher->qos,
+    profile_name, sizeof(profile_name)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+    return false;
+  }
+
+  datawriter_req = uxr_buffer_create_datawriter_ref(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->datawriter_id,
+      custom_publisher->publisher_id, profile_name, mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  datawriter_req = uxr_buffer_create_datawriter_bin(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->datawriter_id,
+      custom_publisher->publisher_id, custom_publisher->topic->topic_id,
+      convert_qos_profile(&custom_publisher->qos), mode);
+#endif
+  flush_entity_request(custom_node);
+
+  requests[0] = publisher_req;
+  requests[1] = datawriter_req;
+  return true;
+}
+
 rmw_publisher_t * create_publisher(
   const rmw_node_t * node, const rosidl_message_type_support_t * type_support,
   const char * topic_name, const rmw_qos_profile_t * qos_policies)
 {
   bool success = false;
 
-  rmw_publisher_t * rmw_publisher = (rmw_publisher_t *)rmw_allocate(sizeof(rmw_publisher_t));
-  rmw_publisher->data = NULL;
-  rmw_publisher->implementation_identifier = rmw_get_implementation_identifier();
-  rmw_publisher->topic_name = (const char *)(rmw_allocate(sizeof(char) * strlen(topic_name) + 1));
-  if (!rmw_publisher->topic_name) {
-    RMW_SET_ERROR_MSG("failed to allocate memory");
-    goto create_publisher_end;
+  rmw_qos_profile_t resolved_qos = *qos_policies;
+  resolve_durability_qos(&resolved_qos);
+  qos_policies = &resolved_qos;
+
+  if (strlen(topic_name) > RMW_TOPIC_NAME_MAX_NAME_LENGTH) {
+    RMW_SET_ERROR_MSG("topic name too long");
+    return NULL;
   }
 
   CustomNode * custom_node = (CustomNode *)node->data;
-  struct Item * memory_node = get_memory(&custom_node->publisher_mem);
-  if (!memory_node) {
+  lock_session(custom_node);
+  CustomPublisher * custom_publisher = (CustomPublisher *)get_memory(&custom_node->publisher_mem);
+  if (!custom_publisher) {
+    unlock_session(custom_node);
     RMW_SET_ERROR_MSG("Not available memory node");
-    goto create_publisher_end;
+    return NULL;
   }
 
+  // The handle and its topic name live in the pooled publisher
+  memcpy(custom_publisher->topic_name, topic_name, strlen(topic_name) + 1);
+  rmw_publisher_t * rmw_publisher = &custom_publisher->rmw_handle;
+  rmw_publisher->implementation_identifier = rmw_get_implementation_identifier();
+  rmw_publisher->topic_name = custom_publisher->topic_name;
+  rmw_publisher->data = custom_publisher;
+
   // TODO(Borja) micro_xrcedds_id is duplicated in publisher_id and in publisher_gid.data
-  CustomPublisher * custom_publisher = (CustomPublisher *)memory_node->data;
   custom_publisher->owner_node = custom_node;
   custom_publisher->publisher_gid.implementation_identifier = rmw_get_implementation_identifier();
   custom_publisher->session = &custom_node->session;
+  custom_publisher->qos = *qos_policies;
 
   if ((type_support == get_message_typesupport_handle(type_support,
     ROSIDL_TYPESUPPORT_MICROXRCEDDS_C__IDENTIFIER_VALUE)) ||
@@ -80,59 +162,13 @@ rmw_publisher_t * create_publisher(
     goto create_publisher_end;
   }
 
-#ifdef MICRO_XRCEDDS_USE_XML
-  char xml_buffer[400];
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  char profile_name[64];
-#endif
-
   custom_publisher->publisher_id = uxr_object_id(custom_node->id_gen++, UXR_PUBLISHER_ID);
-  uint16_t publisher_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  char publisher_name[20];
-  generate_name(&custom_publisher->publisher_id, publisher_name, sizeof(publisher_name));
-  if (!build_publisher_xml(publisher_name, xml_buffer, sizeof(xml_buffer))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for publisher creation");
-    goto create_publisher_end;
-  }
-  publisher_req = uxr_buffer_create_publisher_xml(custom_publisher->session,
-      custom_node->reliable_output, custom_publisher->publisher_id,
-      custom_node->participant_id, xml_buffer, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  // TODO(BORJA) Publisher by reference does not make sense
-  //             in current micro XRCE-DDS implementation.
-  publisher_req = uxr_buffer_create_publisher_xml(custom_publisher->session,
-      custom_node->reliable_output, custom_publisher->publisher_id,
-      custom_node->participant_id, "", UXR_REPLACE);
-#endif
-
   custom_publisher->datawriter_id = uxr_object_id(custom_node->id_gen++, UXR_DATAWRITER_ID);
-  uint16_t datawriter_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  if (!build_datawriter_xml(topic_name, custom_publisher->type_support_callbacks,
-    qos_policies, xml_buffer, sizeof(xml_buffer)))
-  {
-    RMW_SET_ERROR_MSG("failed to generate xml request for publisher creation");
-    goto create_publisher_end;
-  }
-
-  datawriter_req = uxr_buffer_create_datawriter_xml(
-    custom_publisher->session, custom_node->reliable_output, custom_publisher->datawriter_id,
-    custom_publisher->publisher_id, xml_buffer, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  if (!build_datawriter_profile(topic_name, profile_name, sizeof(profile_name))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+  uint16_t requests[2];
+  if (!buffer_create_publisher(custom_publisher, ENTITY_CREATION_MODE, requests)) {
     goto create_publisher_end;
   }
 
-  datawriter_req = uxr_buffer_create_datawriter_ref(custom_publisher->session,
-      custom_node->reliable_output, custom_publisher->datawriter_id,
-      custom_publisher->publisher_id, profile_name, UXR_REPLACE);
-#endif
-
-  rmw_publisher->data = custom_publisher;
-
-  uint16_t requests[] = {publisher_req, datawriter_req};
   uint8_t status[sizeof(requests) / 2];
   if (!uxr_run_session_until_all_status(custom_publisher->session, 1000, requests,
     status, sizeof(status)))
@@ -149,6 +185,7 @@ create_publisher_end:
     rmw_publisher_delete(rmw_publisher);
     rmw_publisher = NULL;
   }
+  unlock_session(custom_node);
   return rmw_publisher;
 }
 
@@ -179,6 +216,7 @@ rmw_ret_t rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
   } else {
     CustomNode * custom_node = (CustomNode *)node->data;
     CustomPublisher * custom_publisher = (CustomPublisher *)publisher->data;
+    lock_session(custom_node);
     uint16_t delete_writer = uxr_buffer_delete_entity(custom_publisher->session,
         custom_publisher->owner_node->reliable_output,
         custom_publisher->datawriter_id);
@@ -197,6 +235,7 @@ rmw_ret_t rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
       rmw_publisher_delete(publisher);
       result_ret = RMW_RET_OK;
     }
+    unlock_session(custom_node);
   }
 
   return result_ret;
@@ -228,17 +267,35 @@ rmw_ret_t rmw_publish(const rmw_publisher_t * publisher, const void * ros_messag
     payload_length = (uint16_t)(payload_length + 4);  // request_id + object_id
     payload_length = (uint16_t)(payload_length + 4);  // request_id + object_id
 
+    CustomNode * custom_node = custom_publisher->owner_node;
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+    // Delivery is left to the node I/O thread
+    if (!agent_reachable(custom_node)) {
+      RMW_SET_ERROR_MSG("agent is not reachable");
+      written = false;
+    } else {
+      written = queue_publish(custom_publisher, ros_message, topic_length);
+    }
+#else
     ucdrBuffer mb;
-    if (uxr_prepare_output_stream(custom_publisher->session,
-      custom_publisher->owner_node->reliable_output, custom_publisher->datawriter_id, &mb,
+    lock_session(custom_node);
+    if (!check_agent_liveliness(custom_node)) {
+      RMW_SET_ERROR_MSG("agent is not reachable");
+      written = false;
+    } else if (uxr_prepare_output_stream(custom_publisher->session,
+      custom_node->reliable_output, custom_publisher->datawriter_id, &mb,
       topic_length))
     {
       ucdrBuffer mb_topic;
       ucdr_init_buffer(&mb_topic, mb.iterator, topic_length);
       written &= functions->cdr_serialize(ros_message, &mb_topic);
 
-      written &= uxr_run_session_until_confirm_delivery(custom_publisher->session, 1000);
+      bool confirmed = uxr_run_session_until_confirm_delivery(custom_publisher->session, 1000);
+      report_agent_activity(custom_node, confirmed);
+      written &= confirmed;
     }
+    unlock_session(custom_node);
+#endif
     if (!written) {
       RMW_SET_ERROR_MSG("error publishing message");
       ret = RMW_RET_ERROR;
@@ -18,8 +18,16 @@
 #include <rmw/types.h>
 #include <rosidl_generator_c/message_type_support_struct.h>
 
+#include "./types.h"
+
 rmw_publisher_t * create_publisher(
   const rmw_node_t * node, const rosidl_message_type_support_t * type_support,
   const char * topic_name, const rmw_qos_profile_t * qos_policies);
 
+// Buffers the publisher and datawriter creation requests for an already initialized
+// publisher, used both at creation and to recreate it on a new agent session.
+bool buffer_create_publisher(
+  CustomPublisher * custom_publisher, uint8_t mode,
+  uint16_t requests[2]);
+
 #endif  // RMW_PUBLISHER_H_
@@ -18,45 +18,125 @@
 #include <rmw/error_handling.h>
 #include <rosidl_typesupport_microxrcedds_shared/identifier.h>
 
+#include "./io_thread.h"
 #include "./rmw_microxrcedds.h"
+#include "./rmw_node.h"
 #include "./types.h"
 #include "./utils.h"
 #include "./rmw_microxrcedds_topic.h"
 
+bool buffer_create_subscriber(
+  CustomSubscription * custom_subscription, uint8_t mode,
+  uint16_t requests[2])
+{
+  CustomNode * custom_node = custom_subscription->owner_node;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char xml_buffer[512];
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  char profile_name[96];
+#endif
+
+  uint16_t subscriber_req;
+#ifdef MICRO_XRCEDDS_USE_XML
+  char subscriber_name[20];
+  generate_name(&custom_subscription->subscriber_id, subscriber_name, sizeof(subscriber_name));
+  if (!build_subscriber_xml(subscriber_name, xml_buffer, sizeof(xml_buffer))) {
+    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
+    return false;
+  }
+  subscriber_req = uxr_buffer_create_subscriber_xml(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->subscriber_id,
+      custom_node->participant_id, xml_buffer, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  // TODO(BORJA)  Publisher by reference does not make sense in
+  //              current micro XRCE-DDS implementation.
+  subscriber_req = uxr_buffer_create_subscriber_xml(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->subscriber_id,
+      custom_node->participant_id, "", mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  subscriber_req = uxr_buffer_create_subscriber_bin(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->subscriber_id,
+      custom_node->participant_id, mode);
+#endif
+  flush_entity_request(custom_node);
+
+  uint16_t datareader_req;
+#ifdef MICRO_XRCEDDS_USE_XML
+  if (!build_datareader_xml(custom_subscription->topic, &custom_subscription->qos, xml_buffer,
+    sizeof(xml_buffer)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
+    return false;
+  }
+
+  datareader_req = uxr_buffer_create_datareader_xml(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->datareader_id,
+      custom_subscription->subscriber_id, xml_buffer, mode);
+#elif defined(MICRO_XRCEDDS_USE_REFS)
+  if (!build_datareader_profile(custom_subscription->topic_name, &custom_subscription->qos,
+    profile_name, sizeof(profile_name)))
+  {
+    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
+    return false;
+  }
+
+  datareader_req = uxr_buffer_create_datareader_ref(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->datareader_id,
+      custom_subscription->subscriber_id, profile_name, mode);
+#elif defined(MICRO_XRCEDDS_USE_BIN)
+  datareader_req = uxr_buffer_create_datareader_bin(&custom_node->session,
+      custom_node->reliable_output, custom_subscription->datareader_id,
+      custom_subscription->subscriber_id, custom_subscription->topic->topic_id,
+      convert_qos_profile(&custom_subscription->qos), mode);
+#endif
+  flush_entity_request(custom_node);
+
+  requests[0] = subscriber_req;
+  requests[1] = datareader_req;
+  return true;
+}
+
 rmw_subscription_t * create_subscriber(
   const rmw_node_t * node, const rosidl_message_type_support_t * type_support,
   const char * topic_name, const rmw_qos_profile_t * qos_policies,
   bool ignore_local_publications)
 {
   bool success = false;
-  (void)qos_policies;
   (void)ignore_local_publications;
 
-  rmw_subscription_t * rmw_subscriber = (rmw_subscription_t *)rmw_allocate(
-    sizeof(rmw_subscription_t));
-  rmw_subscriber->data = NULL;
-  rmw_subscriber->implementation_identifier = rmw_get_implementation_identifier();
-  rmw_subscriber->topic_name = (const char *)(rmw_allocate(sizeof(char) * strlen(topic_name) + 1));
-  if (!rmw_subscriber->topic_name) {
-    RMW_SET_ERROR_MSG("failed to allocate memory");
-    goto create_subscriber_end;
+  rmw_qos_profile_t resolved_qos = *qos_policies;
+  resolve_durability_qos(&resolved_qos);
+  qos_policies = &resolved_qos;
+
+  if (strlen(topic_name) > RMW_TOPIC_NAME_MAX_NAME_LENGTH) {
+    RMW_SET_ERROR_MSG("topic name too long");
+    return NULL;
   }
 
   CustomNode * custom_node = (CustomNode *)node->data;
-  struct Item * memory_node = get_memory(&custom_node->subscription_mem);
-  if (!memory_node) {
+  lock_session(custom_node);
+  CustomSubscription * custom_subscription =
+    (CustomSubscription *)get_memory(&custom_node->subscription_mem);
+  if (!custom_subscription) {
+    unlock_session(custom_node);
     RMW_SET_ERROR_MSG("Not available memory node");
-    goto create_subscriber_end;
+    return NULL;
   }
 
+  // The handle and its topic name live in the pooled subscription
+  memcpy(custom_subscription->topic_name, topic_name, strlen(topic_name) + 1);
+  rmw_subscription_t * rmw_subscriber = &custom_subscription->rmw_handle;
+  rmw_subscriber->implementation_identifier = rmw_get_implementation_identifier();
+  rmw_subscriber->topic_name = custom_subscription->topic_name;
+  rmw_subscriber->data = custom_subscription;
+
   // TODO(Borja) micro_xrcedds_id is duplicated in subscriber_id and in subscription_gid.data
-  CustomSubscription * custom_subscription = (CustomSubscription *)memory_node->data;
   custom_subscription->owner_node = custom_node;
   custom_subscription->subscription_gid.implementation_identifier =
     rmw_get_implementation_identifier();
   custom_subscription->session = &custom_node->session;
   custom_subscription->waiting_for_response = false;
-  custom_subscription->micro_buffer_in_use = false;
+  init_subscription_history(custom_subscription, qos_policies);
 
   if ((type_support == get_message_typesupport_handle(type_support,
     ROSIDL_TYPESUPPORT_MICROXRCEDDS_C__IDENTIFIER_VALUE)) ||
@@ -85,67 +165,25 @@ rmw_subscription_t * create_subscriber(
     goto create_subscriber_end;
   }
 
-#ifdef MICRO_XRCEDDS_USE_XML
-  char xml_buffer[400];
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  char profile_name[64];
-#endif
-
   custom_subscription->subscriber_id = uxr_object_id(custom_node->id_gen++, UXR_SUBSCRIBER_ID);
-  uint16_t subscriber_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  char subscriber_name[20];
-  generate_name(&custom_subscription->subscriber_id, subscriber_name, sizeof(subscriber_name));
-  if (!build_subscriber_xml(subscriber_name, xml_buffer, sizeof(xml_buffer))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
-    goto create_subscriber_end;
-  }
-  subscriber_req = uxr_buffer_create_subscriber_xml(&custom_node->session,
-      custom_node->reliable_output, custom_subscription->subscriber_id,
-      custom_node->participant_id, xml_buffer, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  // TODO(BORJA)  Publisher by reference does not make sense in
-  //              current micro XRCE-DDS implementation.
-  subscriber_req = uxr_buffer_create_subscriber_xml(&custom_node->session,
-      custom_node->reliable_output, custom_subscription->subscriber_id,
-      custom_node->participant_id, "", UXR_REPLACE);
-#endif
-
-
   custom_subscription->datareader_id = uxr_object_id(custom_node->id_gen++, UXR_DATAREADER_ID);
-  uint16_t datareader_req;
-#ifdef MICRO_XRCEDDS_USE_XML
-  if (!build_datareader_xml(topic_name, custom_subscription->type_support_callbacks,
-    qos_policies, xml_buffer,
-    sizeof(xml_buffer)))
-  {
-    RMW_SET_ERROR_MSG("failed to generate xml request for subscriber creation");
+  uint16_t requests[2];
+  if (!buffer_create_subscriber(custom_subscription, ENTITY_CREATION_MODE, requests)) {
     goto create_subscriber_end;
   }
 
-  datareader_req = uxr_buffer_create_datareader_xml(&custom_node->session,
-      custom_node->reliable_output, custom_subscription->datareader_id,
-      custom_subscription->subscriber_id, xml_buffer, UXR_REPLACE);
-#elif defined(MICRO_XRCEDDS_USE_REFS)
-  if (!build_datareader_profile(topic_name, profile_name, sizeof(profile_name))) {
-    RMW_SET_ERROR_MSG("failed to generate xml request for node creation");
-    goto create_subscriber_end;
-  }
-
-  datareader_req = uxr_buffer_create_datareader_ref(&custom_node->session,
-      custom_node->reliable_output, custom_subscription->datareader_id,
-      custom_subscription->subscriber_id, profile_name, UXR_REPLACE);
-#endif
-
-  rmw_subscriber->data = custom_subscription;
-
-  uint16_t requests[] = {subscriber_req, datareader_req};
   uint8_t status[sizeof(requests) / 2];
   if (!uxr_run_session_until_all_status(&custom_node->session, 1000, requests,
     status, sizeof(status)))
   {
     RMW_SET_ERROR_MSG("Issues creating micro XRCE-DDS entities");
-    put_memory(&custom_node->subscription_mem, &custom_subscription->mem);
+    goto create_subscriber_end;
+  }
+
+  // Late joiners fetch the samples kept by the agent side writers in one request
+  if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL) {
+    request_subscription_data(custom_subscription);
+    uxr_flash_output_streams(&custom_node->session);
   }
 
   success = true;
@@ -156,6 +194,7 @@ create_subscriber_end:
     rmw_subscription_delete(rmw_subscriber);
     rmw_subscriber = NULL;
   }
+  unlock_session(custom_node);
   return rmw_subscriber;
 }
 
@@ -186,6 +225,7 @@ rmw_ret_t rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subsc
   } else {
     CustomNode * custom_node = (CustomNode *)node->data;
     CustomSubscription * custom_subscription = (CustomSubscription *)subscription->data;
+    lock_session(custom_node);
     uint16_t delete_datareader =
       uxr_buffer_delete_entity(&custom_node->session, custom_node->reliable_output,
         custom_subscription->datareader_id);
@@ -204,7 +244,101 @@ rmw_ret_t rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subsc
       rmw_subscription_delete(subscription);
       result_ret = RMW_RET_OK;
     }
+    unlock_session(custom_node);
   }
 
   return result_ret;
 }
+
+void init_subscription_history(
+  CustomSubscription * subscription,
+  const rmw_qos_profile_t * qos_policies)
+{
+  subscription->qos = *qos_policies;
+  subscription->history_head = 0;
+  subscription->history_count = 0;
+  subscription->requested_samples = 0;
+
+  if (qos_policies->history == RMW_QOS_POLICY_HISTORY_KEEP_ALL) {
+    subscription->history_depth = subscription->history_capacity;
+  } else if (qos_policies->depth == 0) {
+    subscription->history_depth = 1;
+  } else if (qos_policies->depth > subscription->history_capacity) {
+    subscription->history_depth = subscription->history_capacity;
+  } else {
+    subscription->history_depth = qos_policies->depth;
+  }
+}
+
+bool push_subscription_sample(CustomSubscription * subscription, struct ucdrBuffer * serialization)
+{
+  size_t length = ucdr_buffer_remaining(serialization);
+  if (length > MAX_TRANSPORT_MTU) {
+    RMW_SET_ERROR_MSG("sample does not fit in subscription history");
+    return false;
+  }
+
+  if (subscription->history_count == subscription->history_depth) {
+    if (subscription->qos.history == RMW_QOS_POLICY_HISTORY_KEEP_ALL) {
+      RMW_SET_ERROR_MSG("subscription history is full");
+      return false;
+    }
+
+    // Keep last: drop the oldest sample.
+    subscription->history_head = (subscription->history_head + 1) % subscription->history_depth;
+    subscription->history_count--;
+  }
+
+  size_t slot = (subscription->history_head + subscription->history_count) %
+    subscription->history_depth;
+  memcpy(&subscription->history_buffer[slot * MAX_TRANSPORT_MTU], serialization->iterator, length);
+  subscription->history_length[slot] = length;
+  subscription->history_count++;
+
+  return true;
+}
+
+bool front_subscription_sample(CustomSubscription * subscription, struct ucdrBuffer * serialization)
+{
+  if (subscription->history_count == 0) {
+    return false;
+  }
+
+  size_t slot = subscription->history_head;
+  ucdr_init_buffer(serialization, &subscription->history_buffer[slot * MAX_TRANSPORT_MTU],
+    (uint32_t)subscription->history_length[slot]);
+  return true;
+}
+
+void pop_subscription_sample(CustomSubscription * subscription)
+{
+  if (subscription->history_count > 0) {
+    subscription->history_head = (subscription->history_head + 1) % subscription->history_depth;
+    subscription->history_count--;
+  }
+}
+
+uint16_t request_subscription_data(CustomSubscription * subscription)
+{
+  // Keep last asks for a full history worth of samples, the local queue drops the
+  // oldest ones. Keep all only asks for what can be stored without dropping.
+  uint16_t max_samples = (uint16_t)subscription->history_depth;
+  if (subscription->qos.history == RMW_QOS_POLICY_HISTORY_KEEP_ALL) {
+    max_samples = (uint16_t)(subscription->history_depth - subscription->history_count);
+  }
+
+  uxrDeliveryControl delivery_control;
+  delivery_control.max_samples = max_samples;
+  delivery_control.max_elapsed_time = UXR_MAX_ELAPSED_TIME_UNLIMITED;
+  delivery_control.max_bytes_per_second = UXR_MAX_BYTES_PER_SECOND_UNLIMITED;
+  delivery_control.min_pace_period = UXR_MIN_PACE_PERIOD_NONE;
+
+  CustomNode * custom_node = subscription->owner_node;
+  subscription->requested_samples = max_samples;
+  subscription->waiting_for_response = true;
+  subscription->subscription_request = uxr_buffer_request_data(&custom_node->session,
+      custom_node->reliable_output, subscription->datareader_id,
+      custom_node->reliable_input, &delivery_control);
+
+  return subscription->subscription_request;
+}
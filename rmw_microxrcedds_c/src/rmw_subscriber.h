@@ -18,9 +18,36 @@
 #include <rmw/types.h>
 #include <rosidl_generator_c/message_type_support_struct.h>
 
+#include "./types.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
 rmw_subscription_t * create_subscriber(
   const rmw_node_t * node, const rosidl_message_type_support_t * type_support,
   const char * topic_name, const rmw_qos_profile_t * qos_policies,
   bool ignore_local_publications);
 
+// Buffers the subscriber and datareader creation requests for an already initialized
+// subscription, used both at creation and to recreate it on a new agent session.
+bool buffer_create_subscriber(
+  CustomSubscription * custom_subscription, uint8_t mode,
+  uint16_t requests[2]);
+
+void init_subscription_history(
+  CustomSubscription * subscription,
+  const rmw_qos_profile_t * qos_policies);
+bool push_subscription_sample(CustomSubscription * subscription, struct ucdrBuffer * serialization);
+bool front_subscription_sample(
+  CustomSubscription * subscription,
+  struct ucdrBuffer * serialization);
+void pop_subscription_sample(CustomSubscription * subscription);
+uint16_t request_subscription_data(CustomSubscription * subscription);
+
+#if defined(__cplusplus)
+}
+#endif
+
 #endif  // RMW_SUBSCRIBER_H_
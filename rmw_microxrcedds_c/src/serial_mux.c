@@ -0,0 +1,475 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./serial_mux.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_SERIAL_MUX
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+#include "rmw_microxrcedds.h"
+
+#define FRAMING_BEGIN_FLAG 0x7E
+#define FRAMING_ESC_FLAG 0x7D
+#define FRAMING_XOR_FLAG 0x20
+#define FRAMING_HEADER_SIZE 4
+#define FRAMING_CRC_SIZE 2
+// Every octet after the flag may be escaped
+#define FRAMING_MAX_SIZE \
+  (1 + 2 * (FRAMING_HEADER_SIZE + UXR_CONFIG_SERIAL_TRANSPORT_MTU + FRAMING_CRC_SIZE))
+
+#define AGENT_ADDRESS 0x00
+#define MAX_MUX_CHANNELS MAX_NODES
+#define MUX_READ_CHUNK 256
+
+enum SerialMuxState
+{
+  MUX_WAIT_FLAG,
+  MUX_READ_SRC,
+  MUX_READ_DST,
+  MUX_READ_LEN_LSB,
+  MUX_READ_LEN_MSB,
+  MUX_READ_PAYLOAD,
+  MUX_READ_CRC_LSB,
+  MUX_READ_CRC_MSB
+};
+
+struct SerialMux
+{
+  char device[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  int fd;
+  SerialMuxChannel * channels[MAX_MUX_CHANNELS];
+  size_t channel_count;
+  // A session is reading the device, the others wait for it to dispatch
+  bool reading;
+
+  // Frame being decoded
+  enum SerialMuxState state;
+  bool escaped;
+  uint8_t src;
+  uint8_t dst;
+  uint16_t length;
+  uint16_t position;
+  uint16_t crc;
+  uint16_t received_crc;
+  uint8_t frame[UXR_CONFIG_SERIAL_TRANSPORT_MTU];
+
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  pthread_mutex_t mutex;
+  pthread_cond_t dispatched;
+#endif
+};
+
+static struct SerialMux serial_muxes[MAX_NODES];
+
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lock_registry(void)
+{
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  pthread_mutex_lock(&registry_mutex);
+#endif
+}
+
+static void unlock_registry(void)
+{
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  pthread_mutex_unlock(&registry_mutex);
+#endif
+}
+
+static void lock_mux(struct SerialMux * mux)
+{
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  pthread_mutex_lock(&mux->mutex);
+#else
+  (void)mux;
+#endif
+}
+
+static void unlock_mux(struct SerialMux * mux)
+{
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  pthread_mutex_unlock(&mux->mutex);
+#else
+  (void)mux;
+#endif
+}
+
+// Clock of the dispatched condition, macOS only waits on the realtime one
+#ifdef __APPLE__
+#define DISPATCH_CLOCK CLOCK_REALTIME
+#else
+#define DISPATCH_CLOCK CLOCK_MONOTONIC
+#endif
+
+static int64_t monotonic_ms(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Waits for the reading session to dispatch, a negative timeout waits forever.
+static void wait_dispatch(struct SerialMux * mux, int timeout)
+{
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  if (timeout < 0) {
+    pthread_cond_wait(&mux->dispatched, &mux->mutex);
+    return;
+  }
+  struct timespec deadline;
+  clock_gettime(DISPATCH_CLOCK, &deadline);
+  deadline.tv_sec += timeout / 1000;
+  deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  pthread_cond_timedwait(&mux->dispatched, &mux->mutex, &deadline);
+#else
+  (void)mux;
+  (void)timeout;
+#endif
+}
+
+static void update_crc(uint16_t * crc, uint8_t octet)
+{
+  // CRC-16/ARC, as the agent checks it
+  *crc ^= octet;
+  for (int i = 0; i < 8; i++) {
+    *crc = (*crc & 1u) ? (uint16_t)((*crc >> 1) ^ 0xA001u) : (uint16_t)(*crc >> 1);
+  }
+}
+
+static bool add_octet(uint8_t * frame, size_t capacity, size_t * position, uint8_t octet)
+{
+  bool escape = (octet == FRAMING_BEGIN_FLAG) || (octet == FRAMING_ESC_FLAG);
+  if (*position + (escape ? 2 : 1) > capacity) {
+    return false;
+  }
+  if (escape) {
+    frame[(*position)++] = FRAMING_ESC_FLAG;
+    octet ^= FRAMING_XOR_FLAG;
+  }
+  frame[(*position)++] = octet;
+  return true;
+}
+
+size_t serial_mux_frame(
+  const uint8_t * payload, size_t length, uint8_t src, uint8_t dst,
+  uint8_t * frame, size_t capacity)
+{
+  if ((length == 0) || (length > UXR_CONFIG_SERIAL_TRANSPORT_MTU) || (capacity == 0)) {
+    return 0;
+  }
+
+  size_t position = 0;
+  frame[position++] = FRAMING_BEGIN_FLAG;
+  bool fits = add_octet(frame, capacity, &position, src) &&
+    add_octet(frame, capacity, &position, dst) &&
+    add_octet(frame, capacity, &position, (uint8_t)(length & 0xFF)) &&
+    add_octet(frame, capacity, &position, (uint8_t)(length >> 8));
+
+  uint16_t crc = 0;
+  for (size_t i = 0; fits && (i < length); i++) {
+    update_crc(&crc, payload[i]);
+    fits = add_octet(frame, capacity, &position, payload[i]);
+  }
+  fits = fits && add_octet(frame, capacity, &position, (uint8_t)(crc & 0xFF)) &&
+    add_octet(frame, capacity, &position, (uint8_t)(crc >> 8));
+  return fits ? position : 0;
+}
+
+// Called with the mux lock held.
+static void dispatch_frame(struct SerialMux * mux)
+{
+  if (mux->src != AGENT_ADDRESS) {
+    return;
+  }
+  for (size_t i = 0; i < mux->channel_count; i++) {
+    SerialMuxChannel * channel = mux->channels[i];
+    if (channel->address != mux->dst) {
+      continue;
+    }
+    // A full queue drops the frame, reliable streams get it again
+    if (channel->queue_count < SERIAL_MUX_QUEUE_SIZE) {
+      size_t tail = (channel->queue_head + channel->queue_count) % SERIAL_MUX_QUEUE_SIZE;
+      memcpy(channel->queue[tail], mux->frame, mux->length);
+      channel->queue_length[tail] = mux->length;
+      channel->queue_count++;
+    }
+    return;
+  }
+}
+
+static void decode_octet(struct SerialMux * mux, uint8_t octet)
+{
+  if (octet == FRAMING_BEGIN_FLAG) {
+    mux->state = MUX_READ_SRC;
+    mux->escaped = false;
+    return;
+  }
+  if (mux->state == MUX_WAIT_FLAG) {
+    return;
+  }
+  if (octet == FRAMING_ESC_FLAG) {
+    mux->escaped = true;
+    return;
+  }
+  if (mux->escaped) {
+    octet ^= FRAMING_XOR_FLAG;
+    mux->escaped = false;
+  }
+
+  switch (mux->state) {
+    case MUX_READ_SRC:
+      mux->src = octet;
+      mux->state = MUX_READ_DST;
+      break;
+    case MUX_READ_DST:
+      mux->dst = octet;
+      mux->state = MUX_READ_LEN_LSB;
+      break;
+    case MUX_READ_LEN_LSB:
+      mux->length = octet;
+      mux->state = MUX_READ_LEN_MSB;
+      break;
+    case MUX_READ_LEN_MSB:
+      mux->length = (uint16_t)(mux->length | (octet << 8));
+      mux->position = 0;
+      mux->crc = 0;
+      mux->state = ((mux->length == 0) || (mux->length > sizeof(mux->frame))) ?
+        MUX_WAIT_FLAG : MUX_READ_PAYLOAD;
+      break;
+    case MUX_READ_PAYLOAD:
+      mux->frame[mux->position++] = octet;
+      update_crc(&mux->crc, octet);
+      if (mux->position == mux->length) {
+        mux->state = MUX_READ_CRC_LSB;
+      }
+      break;
+    case MUX_READ_CRC_LSB:
+      mux->received_crc = octet;
+      mux->state = MUX_READ_CRC_MSB;
+      break;
+    case MUX_READ_CRC_MSB:
+      mux->received_crc = (uint16_t)(mux->received_crc | (octet << 8));
+      if (mux->received_crc == mux->crc) {
+        dispatch_frame(mux);
+      }
+      mux->state = MUX_WAIT_FLAG;
+      break;
+    default:
+      mux->state = MUX_WAIT_FLAG;
+      break;
+  }
+}
+
+static bool send_mux_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  SerialMuxChannel * channel = (SerialMuxChannel *)instance;
+  struct SerialMux * mux = channel->mux;
+  uint8_t frame[FRAMING_MAX_SIZE];
+  size_t frame_length = serial_mux_frame(buf, len, channel->address, AGENT_ADDRESS, frame,
+      sizeof(frame));
+  if (frame_length == 0) {
+    return false;
+  }
+
+  // Frames of different sessions must not interleave
+  lock_mux(mux);
+  size_t written = 0;
+  while (written < frame_length) {
+    ssize_t result = write(mux->fd, &frame[written], frame_length - written);
+    if (result > 0) {
+      written += (size_t)result;
+    } else if ((result < 0) && (errno != EINTR) && (errno != EAGAIN)) {
+      break;
+    }
+  }
+  unlock_mux(mux);
+  return written == frame_length;
+}
+
+static bool recv_mux_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  SerialMuxChannel * channel = (SerialMuxChannel *)instance;
+  struct SerialMux * mux = channel->mux;
+  int64_t deadline = monotonic_ms() + timeout;
+
+  lock_mux(mux);
+  for (bool first = true; ; first = false) {
+    if (channel->queue_count > 0) {
+      *len = channel->queue_length[channel->queue_head];
+      memcpy(channel->buffer, channel->queue[channel->queue_head], *len);
+      channel->queue_head = (channel->queue_head + 1) % SERIAL_MUX_QUEUE_SIZE;
+      channel->queue_count--;
+      unlock_mux(mux);
+      *buf = channel->buffer;
+      return true;
+    }
+
+    int remaining = -1;
+    if (timeout >= 0) {
+      int64_t left = deadline - monotonic_ms();
+      if (!first && (left <= 0)) {
+        break;
+      }
+      remaining = (left > 0) ? (int)left : 0;
+    }
+
+    if (mux->reading) {
+      wait_dispatch(mux, remaining);
+      continue;
+    }
+
+    // Read for every session, without the lock so they can write meanwhile
+    mux->reading = true;
+    unlock_mux(mux);
+    uint8_t chunk[MUX_READ_CHUNK];
+    ssize_t received = 0;
+    struct pollfd poll_fd = {mux->fd, POLLIN, 0};
+    if (poll(&poll_fd, 1, remaining) > 0) {
+      received = read(mux->fd, chunk, sizeof(chunk));
+    }
+    lock_mux(mux);
+    for (ssize_t i = 0; i < received; i++) {
+      decode_octet(mux, chunk[i]);
+    }
+    mux->reading = false;
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+    pthread_cond_broadcast(&mux->dispatched);
+#endif
+  }
+  unlock_mux(mux);
+  return false;
+}
+
+static uint8_t get_mux_error(void)
+{
+  return 0;
+}
+
+static uint8_t free_address(const struct SerialMux * mux)
+{
+  for (unsigned address = 1; address <= UINT8_MAX; address++) {
+    bool used = false;
+    for (size_t i = 0; i < mux->channel_count; i++) {
+      used |= (mux->channels[i]->address == address);
+    }
+    if (!used) {
+      return (uint8_t)address;
+    }
+  }
+  return AGENT_ADDRESS;
+}
+
+bool open_serial_mux_channel(
+  SerialMuxChannel * channel, const char * device,
+  int (* open_device)(void * args), void * args)
+{
+  if (strlen(device) >= RMW_UXRCE_ENDPOINT_MAX_LENGTH) {
+    return false;
+  }
+
+  lock_registry();
+  struct SerialMux * mux = NULL;
+  struct SerialMux * unused = NULL;
+  for (size_t i = 0; i < MAX_NODES; i++) {
+    if (serial_muxes[i].channel_count == 0) {
+      unused = (unused == NULL) ? &serial_muxes[i] : unused;
+    } else if (strcmp(serial_muxes[i].device, device) == 0) {
+      mux = &serial_muxes[i];
+    }
+  }
+
+  if (mux == NULL) {
+    int fd = (unused != NULL) ? open_device(args) : -1;
+    if (fd < 0) {
+      unlock_registry();
+      return false;
+    }
+    mux = unused;
+    memset(mux, 0, sizeof(*mux));
+    memcpy(mux->device, device, strlen(device) + 1);
+    mux->fd = fd;
+    mux->state = MUX_WAIT_FLAG;
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&cond_attr, DISPATCH_CLOCK);
+#endif
+    pthread_mutex_init(&mux->mutex, NULL);
+    pthread_cond_init(&mux->dispatched, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+#endif
+  }
+
+  lock_mux(mux);
+  uint8_t address = free_address(mux);
+  bool attached = (mux->channel_count < MAX_MUX_CHANNELS) && (address != AGENT_ADDRESS);
+  if (attached) {
+    channel->mux = mux;
+    channel->address = address;
+    channel->queue_head = 0;
+    channel->queue_count = 0;
+    channel->comm.instance = channel;
+    channel->comm.send_msg = send_mux_msg;
+    channel->comm.recv_msg = recv_mux_msg;
+    channel->comm.comm_error = get_mux_error;
+    channel->comm.mtu = UXR_CONFIG_SERIAL_TRANSPORT_MTU;
+    mux->channels[mux->channel_count++] = channel;
+  }
+  unlock_mux(mux);
+  unlock_registry();
+  return attached;
+}
+
+void close_serial_mux_channel(SerialMuxChannel * channel)
+{
+  struct SerialMux * mux = channel->mux;
+  lock_registry();
+  lock_mux(mux);
+  for (size_t i = 0; i < mux->channel_count; i++) {
+    if (mux->channels[i] == channel) {
+      mux->channels[i] = mux->channels[--mux->channel_count];
+      break;
+    }
+  }
+  size_t remaining = mux->channel_count;
+  unlock_mux(mux);
+
+  // The last session closes the device
+  if (remaining == 0) {
+    close(mux->fd);
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+    pthread_cond_destroy(&mux->dispatched);
+    pthread_mutex_destroy(&mux->mutex);
+#endif
+  }
+  unlock_registry();
+  channel->mux = NULL;
+}
+
+#endif  // MICRO_XRCEDDS_SERIAL_MUX
@@ -0,0 +1,69 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SERIAL_MUX_H_
+#define SERIAL_MUX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <uxr/client/client.h>
+
+#include "./config.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#ifdef MICRO_XRCEDDS_SERIAL_MUX
+// Several sessions over one serial device. Every session gets its own framing address,
+// which is how the agent tells serial clients apart, and frames use the XRCE serial
+// framing (flag, escaping, addresses, length and CRC-16). One session at a time reads
+// the device and queues the frames of the others in their channel.
+struct SerialMux;
+
+typedef struct SerialMuxChannel
+{
+  uxrCommunication comm;
+  struct SerialMux * mux;
+  uint8_t address;
+
+  // Frames read by other sessions for this one
+  uint8_t queue[SERIAL_MUX_QUEUE_SIZE][UXR_CONFIG_SERIAL_TRANSPORT_MTU];
+  size_t queue_length[SERIAL_MUX_QUEUE_SIZE];
+  size_t queue_head;
+  size_t queue_count;
+  uint8_t buffer[UXR_CONFIG_SERIAL_TRANSPORT_MTU];
+} SerialMuxChannel;
+
+// Opens the device through open_device for its first channel, later channels of the
+// same device share it. open_device returns a configured descriptor or -1.
+bool open_serial_mux_channel(
+  SerialMuxChannel * channel, const char * device,
+  int (* open_device)(void * args), void * args);
+void close_serial_mux_channel(SerialMuxChannel * channel);
+
+// Frames a message from src to dst, returns the frame length or 0 if it does not fit.
+size_t serial_mux_frame(
+  const uint8_t * payload, size_t length, uint8_t src, uint8_t dst,
+  uint8_t * frame, size_t capacity);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // SERIAL_MUX_H_
@@ -0,0 +1,325 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./shm_transport.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_SHM
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_MAGIC 0x53525855u  // "UXRS"
+#define SHM_FRAME_HEADER sizeof(uint16_t)
+
+#define SLOT_FREE 0u
+#define SLOT_ACTIVE 1u
+#define SLOT_CLAIMING 2u
+
+// Free running positions, the ring size is a power of two.
+struct ShmRing
+{
+  uint32_t head;
+  uint32_t tail;
+};
+
+struct ShmSlot
+{
+  uint32_t state;
+  struct ShmRing to_agent;
+  struct ShmRing to_client;
+};
+
+struct ShmHeader
+{
+  uint32_t magic;
+  uint32_t slot_count;
+  uint32_t ring_size;
+  struct ShmSlot slots[];
+};
+
+static size_t segment_size(size_t slot_count, size_t ring_size)
+{
+  return sizeof(struct ShmHeader) + slot_count * (sizeof(struct ShmSlot) + 2 * ring_size);
+}
+
+static uint8_t * ring_data(struct ShmHeader * header, size_t slot, bool to_agent)
+{
+  uint8_t * base = (uint8_t *)&header->slots[header->slot_count];
+  return base + (2 * slot + (to_agent ? 0 : 1)) * header->ring_size;
+}
+
+static void ring_copy_in(uint8_t * data, uint32_t size, uint32_t position, const void * src,
+  size_t length)
+{
+  uint32_t offset = position & (size - 1);
+  size_t first = (length < size - offset) ? length : size - offset;
+  memcpy(&data[offset], src, first);
+  memcpy(data, (const uint8_t *)src + first, length - first);
+}
+
+static void ring_copy_out(const uint8_t * data, uint32_t size, uint32_t position, void * dst,
+  size_t length)
+{
+  uint32_t offset = position & (size - 1);
+  size_t first = (length < size - offset) ? length : size - offset;
+  memcpy(dst, &data[offset], first);
+  memcpy((uint8_t *)dst + first, data, length - first);
+}
+
+static bool ring_write(struct ShmRing * ring, uint8_t * data, uint32_t size, const uint8_t * buffer,
+  size_t length)
+{
+  if ((length == 0) || (length > UINT16_MAX)) {
+    return false;
+  }
+
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  if ((size - (head - tail)) < (length + SHM_FRAME_HEADER)) {
+    return false;
+  }
+
+  uint16_t frame_length = (uint16_t)length;
+  ring_copy_in(data, size, head, &frame_length, SHM_FRAME_HEADER);
+  ring_copy_in(data, size, head + SHM_FRAME_HEADER, buffer, length);
+  __atomic_store_n(&ring->head, head + (uint32_t)(SHM_FRAME_HEADER + length), __ATOMIC_RELEASE);
+  return true;
+}
+
+static bool ring_read(struct ShmRing * ring, const uint8_t * data, uint32_t size, uint8_t * buffer,
+  size_t capacity, size_t * length)
+{
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return false;
+  }
+
+  uint16_t frame_length;
+  ring_copy_out(data, size, tail, &frame_length, SHM_FRAME_HEADER);
+  bool fits = (frame_length <= capacity);
+  if (fits) {
+    ring_copy_out(data, size, tail + SHM_FRAME_HEADER, buffer, frame_length);
+    *length = frame_length;
+  }
+  // Frames larger than the reader MTU are dropped, as a datagram would be
+  __atomic_store_n(&ring->tail, tail + (uint32_t)(SHM_FRAME_HEADER + frame_length),
+    __ATOMIC_RELEASE);
+  return fits;
+}
+
+static int64_t monotonic_ms(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static bool send_shm_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  ShmTransport * transport = (ShmTransport *)instance;
+  struct ShmHeader * header = transport->header;
+  // A full ring drops the message, reliable streams send it again
+  return ring_write(&header->slots[transport->slot_index].to_agent,
+           ring_data(header, transport->slot_index, true), header->ring_size, buf, len);
+}
+
+static bool recv_shm_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  ShmTransport * transport = (ShmTransport *)instance;
+  struct ShmHeader * header = transport->header;
+  struct ShmRing * ring = &header->slots[transport->slot_index].to_client;
+  const uint8_t * data = ring_data(header, transport->slot_index, false);
+
+  int64_t deadline = monotonic_ms() + timeout;
+  for (unsigned attempt = 0; ; attempt++) {
+    if (ring_read(ring, data, header->ring_size, transport->buffer, sizeof(transport->buffer),
+      len))
+    {
+      *buf = transport->buffer;
+      return true;
+    }
+    if ((timeout >= 0) && (monotonic_ms() >= deadline)) {
+      return false;
+    }
+
+    // Stay on the CPU for a short while, then poll at a lower rate
+    if (attempt < 64) {
+      sched_yield();
+    } else {
+      struct timespec pause = {0, 50000};
+      nanosleep(&pause, NULL);
+    }
+  }
+}
+
+static uint8_t get_shm_error(void)
+{
+  return 0;
+}
+
+bool open_shm_transport(ShmTransport * transport, const char * name)
+{
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat segment_stat;
+  if ((fstat(fd, &segment_stat) != 0) ||
+    ((size_t)segment_stat.st_size < sizeof(struct ShmHeader)))
+  {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)segment_stat.st_size;
+  void * segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (segment == MAP_FAILED) {
+    return false;
+  }
+
+  struct ShmHeader * header = (struct ShmHeader *)segment;
+  if ((__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC) ||
+    (segment_size(header->slot_count, header->ring_size) > size))
+  {
+    munmap(segment, size);
+    return false;
+  }
+
+  for (size_t i = 0; i < header->slot_count; i++) {
+    struct ShmSlot * slot = &header->slots[i];
+    uint32_t expected = SLOT_FREE;
+    if (__atomic_compare_exchange_n(&slot->state, &expected, SLOT_CLAIMING, false,
+      __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+      // The endpoint ignores the slot until it is active
+      memset(&slot->to_agent, 0, sizeof(slot->to_agent));
+      memset(&slot->to_client, 0, sizeof(slot->to_client));
+      __atomic_store_n(&slot->state, SLOT_ACTIVE, __ATOMIC_RELEASE);
+
+      transport->header = header;
+      transport->segment_size = size;
+      transport->slot_index = i;
+      transport->comm.instance = transport;
+      transport->comm.send_msg = send_shm_msg;
+      transport->comm.recv_msg = recv_shm_msg;
+      transport->comm.comm_error = get_shm_error;
+      transport->comm.mtu = MAX_TRANSPORT_MTU;
+      return true;
+    }
+  }
+
+  munmap(segment, size);
+  return false;
+}
+
+void close_shm_transport(ShmTransport * transport)
+{
+  if (transport->header != NULL) {
+    __atomic_store_n(&transport->header->slots[transport->slot_index].state, SLOT_FREE,
+      __ATOMIC_RELEASE);
+    munmap(transport->header, transport->segment_size);
+    transport->header = NULL;
+  }
+}
+
+bool create_shm_endpoint(
+  ShmEndpoint * endpoint, const char * name, size_t slot_count,
+  size_t ring_size)
+{
+  if ((slot_count == 0) || (ring_size <= SHM_FRAME_HEADER) || (ring_size > UINT32_MAX / 2) ||
+    ((ring_size & (ring_size - 1)) != 0) || (strlen(name) >= sizeof(endpoint->name)))
+  {
+    return false;
+  }
+
+  // A segment left behind by a previous endpoint is started over
+  shm_unlink(name);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return false;
+  }
+
+  size_t size = segment_size(slot_count, ring_size);
+  void * segment = MAP_FAILED;
+  if (ftruncate(fd, (off_t)size) == 0) {
+    segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (segment == MAP_FAILED) {
+    shm_unlink(name);
+    return false;
+  }
+
+  struct ShmHeader * header = (struct ShmHeader *)segment;
+  memset(header, 0, sizeof(struct ShmHeader) + slot_count * sizeof(struct ShmSlot));
+  header->slot_count = (uint32_t)slot_count;
+  header->ring_size = (uint32_t)ring_size;
+  __atomic_store_n(&header->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+  endpoint->header = header;
+  endpoint->segment_size = size;
+  memcpy(endpoint->name, name, strlen(name) + 1);
+  return true;
+}
+
+void destroy_shm_endpoint(ShmEndpoint * endpoint)
+{
+  if (endpoint->header != NULL) {
+    munmap(endpoint->header, endpoint->segment_size);
+    shm_unlink(endpoint->name);
+    endpoint->header = NULL;
+  }
+}
+
+size_t shm_endpoint_slot_count(const ShmEndpoint * endpoint)
+{
+  return endpoint->header->slot_count;
+}
+
+bool shm_endpoint_slot_in_use(const ShmEndpoint * endpoint, size_t slot)
+{
+  return __atomic_load_n(&endpoint->header->slots[slot].state, __ATOMIC_ACQUIRE) == SLOT_ACTIVE;
+}
+
+bool shm_endpoint_read(
+  ShmEndpoint * endpoint, size_t slot, uint8_t * buffer, size_t capacity,
+  size_t * length)
+{
+  struct ShmHeader * header = endpoint->header;
+  if (!shm_endpoint_slot_in_use(endpoint, slot)) {
+    return false;
+  }
+  return ring_read(&header->slots[slot].to_agent, ring_data(header, slot, true),
+           header->ring_size, buffer, capacity, length);
+}
+
+bool shm_endpoint_write(
+  ShmEndpoint * endpoint, size_t slot, const uint8_t * buffer,
+  size_t length)
+{
+  struct ShmHeader * header = endpoint->header;
+  if (!shm_endpoint_slot_in_use(endpoint, slot)) {
+    return false;
+  }
+  return ring_write(&header->slots[slot].to_client, ring_data(header, slot, false),
+           header->ring_size, buffer, length);
+}
+
+#endif  // MICRO_XRCEDDS_SHM
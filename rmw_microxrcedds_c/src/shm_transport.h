@@ -0,0 +1,79 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SHM_TRANSPORT_H_
+#define SHM_TRANSPORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <uxr/client/client.h>
+
+#include "./config.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// A shared memory segment created by the agent side endpoint holds slot_count slots,
+// each one a pair of single producer single consumer byte rings, one per direction.
+// A client claims a free slot for its session, so the segment carries no syscalls
+// once both sides are attached.
+struct ShmHeader;
+struct ShmSlot;
+
+typedef struct ShmTransport
+{
+  uint8_t buffer[MAX_TRANSPORT_MTU];
+  uxrCommunication comm;
+
+  struct ShmHeader * header;
+  size_t segment_size;
+  size_t slot_index;
+} ShmTransport;
+
+bool open_shm_transport(ShmTransport * transport, const char * name);
+void close_shm_transport(ShmTransport * transport);
+
+// Agent side of the segment, used by the relay tool and the tests.
+typedef struct ShmEndpoint
+{
+  struct ShmHeader * header;
+  size_t segment_size;
+  char name[64];
+} ShmEndpoint;
+
+bool create_shm_endpoint(
+  ShmEndpoint * endpoint, const char * name, size_t slot_count,
+  size_t ring_size);
+void destroy_shm_endpoint(ShmEndpoint * endpoint);
+
+size_t shm_endpoint_slot_count(const ShmEndpoint * endpoint);
+bool shm_endpoint_slot_in_use(const ShmEndpoint * endpoint, size_t slot);
+// Returns false when the slot has no message.
+bool shm_endpoint_read(
+  ShmEndpoint * endpoint, size_t slot, uint8_t * buffer, size_t capacity,
+  size_t * length);
+// Returns false when the ring has no room for the message.
+bool shm_endpoint_write(
+  ShmEndpoint * endpoint, size_t slot, const uint8_t * buffer,
+  size_t length);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // SHM_TRANSPORT_H_
@@ -0,0 +1,667 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./transport.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_SERIAL
+#include <fcntl.h>  // O_RDWR, O_NOCTTY, O_NONBLOCK
+#include <termios.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#endif
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rmw/error_handling.h>
+
+#include "./discovery.h"
+#include "./io_thread.h"
+
+static rmw_uxrce_transport_params_t transport_params;
+static bool transport_requested = false;
+
+static bool copy_endpoint(char destination[], const char * source)
+{
+  size_t length = strlen(source);
+  if (length >= RMW_UXRCE_ENDPOINT_MAX_LENGTH) {
+    return false;
+  }
+  memcpy(destination, source, length + 1);
+  return true;
+}
+
+#ifdef MICRO_XRCEDDS_SERIAL
+static bool get_serial_speed(uint32_t baud_rate, speed_t * speed)
+{
+  switch (baud_rate) {
+    case 9600: *speed = B9600; return true;
+    case 19200: *speed = B19200; return true;
+    case 38400: *speed = B38400; return true;
+    case 57600: *speed = B57600; return true;
+    case 115200: *speed = B115200; return true;
+    case 230400: *speed = B230400; return true;
+#ifdef B460800
+    case 460800: *speed = B460800; return true;
+#endif
+#ifdef B921600
+    case 921600: *speed = B921600; return true;
+#endif
+#ifdef B1000000
+    case 1000000: *speed = B1000000; return true;
+#endif
+#ifdef B1500000
+    case 1500000: *speed = B1500000; return true;
+#endif
+#ifdef B2000000
+    case 2000000: *speed = B2000000; return true;
+#endif
+#ifdef B3000000
+    case 3000000: *speed = B3000000; return true;
+#endif
+#ifdef B4000000
+    case 4000000: *speed = B4000000; return true;
+#endif
+    default: return false;
+  }
+}
+#endif
+
+static bool check_transport_params(const rmw_uxrce_transport_params_t * params)
+{
+  switch (params->kind) {
+#ifdef MICRO_XRCEDDS_UDP
+    case RMW_UXRCE_TRANSPORT_UDP:
+#ifndef MICRO_XRCEDDS_DISCOVERY
+      if (params->agent_discovery) {
+        return false;
+      }
+#endif
+      return (params->agent_ip[0] != '\0') && (params->agent_port != 0);
+#endif
+#ifdef MICRO_XRCEDDS_SERIAL
+    case RMW_UXRCE_TRANSPORT_SERIAL:
+    {
+      speed_t speed;
+      return (params->serial_device[0] != '\0') &&
+             get_serial_speed(params->serial_baud_rate, &speed);
+    }
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+    case RMW_UXRCE_TRANSPORT_TCP:
+      return (params->agent_ip[0] != '\0') && (params->agent_port != 0);
+#endif
+#ifdef MICRO_XRCEDDS_SHM
+    case RMW_UXRCE_TRANSPORT_SHM:
+      return params->shm_name[0] != '\0';
+#endif
+    case RMW_UXRCE_TRANSPORT_CUSTOM:
+      return (params->custom.write != NULL) && (params->custom.read != NULL) &&
+             (params->custom.mtu > 0) && (params->custom.mtu <= MAX_TRANSPORT_MTU);
+    default:
+      return false;
+  }
+}
+
+static bool read_transport_env(rmw_uxrce_transport_params_t * params)
+{
+  const char * value = getenv("RMW_UXRCE_TRANSPORT");
+  if ((value != NULL) && (value[0] != '\0')) {
+    if (strcmp(value, "udp") == 0) {
+      params->kind = RMW_UXRCE_TRANSPORT_UDP;
+    } else if (strcmp(value, "serial") == 0) {
+      params->kind = RMW_UXRCE_TRANSPORT_SERIAL;
+    } else if (strcmp(value, "tcp") == 0) {
+      params->kind = RMW_UXRCE_TRANSPORT_TCP;
+    } else if (strcmp(value, "shm") == 0) {
+      params->kind = RMW_UXRCE_TRANSPORT_SHM;
+    } else {
+      return false;
+    }
+  }
+
+  value = getenv("RMW_UXRCE_AGENT_IP");
+  if ((value != NULL) && (value[0] != '\0')) {
+    // An agent given at run time is not looked for
+    params->agent_discovery = false;
+    if (!copy_endpoint(params->agent_ip, value)) {
+      return false;
+    }
+  }
+
+  value = getenv("RMW_UXRCE_AGENT_PORT");
+  if ((value != NULL) && (value[0] != '\0')) {
+    char * end = NULL;
+    unsigned long port = strtoul(value, &end, 10);  // NOLINT
+    if ((*end != '\0') || (port == 0) || (port > UINT16_MAX)) {
+      return false;
+    }
+    params->agent_port = (uint16_t)port;
+  }
+
+  value = getenv("RMW_UXRCE_SERIAL_DEVICE");
+  if ((value != NULL) && (value[0] != '\0') && !copy_endpoint(params->serial_device, value)) {
+    return false;
+  }
+
+  value = getenv("RMW_UXRCE_SERIAL_BAUD");
+  if ((value != NULL) && (value[0] != '\0')) {
+    char * end = NULL;
+    unsigned long baud_rate = strtoul(value, &end, 10);  // NOLINT
+    if ((*end != '\0') || (baud_rate == 0) || (baud_rate > UINT32_MAX)) {
+      return false;
+    }
+    params->serial_baud_rate = (uint32_t)baud_rate;
+  }
+
+  value = getenv("RMW_UXRCE_SHM_NAME");
+  if ((value != NULL) && (value[0] != '\0') && !copy_endpoint(params->shm_name, value)) {
+    return false;
+  }
+  return true;
+}
+
+rmw_ret_t rmw_uxrce_set_transport(const rmw_uxrce_transport_params_t * params)
+{
+  if (!params) {
+    RMW_SET_ERROR_MSG("transport params is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!check_transport_params(params)) {
+    RMW_SET_ERROR_MSG("transport not supported by this build or endpoint missing");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  lock_memory();
+  transport_params = *params;
+  transport_requested = true;
+  unlock_memory();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_get_transport(rmw_uxrce_transport_params_t * params)
+{
+  if (!params) {
+    RMW_SET_ERROR_MSG("transport params is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  get_transport_params(params);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_uxrce_set_custom_transport(const rmw_uxrce_custom_transport_t * transport)
+{
+  if (!transport) {
+    RMW_SET_ERROR_MSG("custom transport is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_uxrce_transport_params_t params;
+  get_transport_params(&params);
+  params.kind = RMW_UXRCE_TRANSPORT_CUSTOM;
+  params.custom = *transport;
+  return rmw_uxrce_set_transport(&params);
+}
+
+size_t rmw_uxrce_get_max_mtu(void)
+{
+  return MAX_TRANSPORT_MTU;
+}
+
+rmw_ret_t init_transport_params(void)
+{
+  if (transport_requested) {
+    return RMW_RET_OK;
+  }
+
+  rmw_uxrce_transport_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.kind = DEFAULT_TRANSPORT_KIND;
+  params.agent_port = DEFAULT_AGENT_PORT;
+#ifdef MICRO_XRCEDDS_TCP_NODELAY
+  params.tcp_no_delay = true;
+#endif
+  params.tcp_send_buffer_size = DEFAULT_TCP_SEND_BUFFER_SIZE;
+  params.serial_baud_rate = DEFAULT_SERIAL_BAUD_RATE;
+#ifdef MICRO_XRCEDDS_DISCOVERY
+  params.agent_discovery = true;
+#endif
+#ifdef MICRO_XRCEDDS_SERIAL_FLOW_CONTROL
+  params.serial_flow_control = true;
+#endif
+  if (!copy_endpoint(params.agent_ip, DEFAULT_AGENT_IP) ||
+    !copy_endpoint(params.serial_device, DEFAULT_SERIAL_DEVICE) ||
+    !copy_endpoint(params.shm_name, DEFAULT_SHM_NAME) ||
+    !read_transport_env(&params))
+  {
+    RMW_SET_ERROR_MSG("invalid RMW_UXRCE_TRANSPORT, RMW_UXRCE_AGENT_*, "
+      "RMW_UXRCE_SERIAL_* or RMW_UXRCE_SHM_NAME environment variable");
+    return RMW_RET_ERROR;
+  }
+  if (!check_transport_params(&params)) {
+    RMW_SET_ERROR_MSG("transport not supported by this build or endpoint missing");
+    return RMW_RET_ERROR;
+  }
+
+  lock_memory();
+  transport_params = params;
+  unlock_memory();
+  return RMW_RET_OK;
+}
+
+void get_transport_params(rmw_uxrce_transport_params_t * params)
+{
+  lock_memory();
+  *params = transport_params;
+  unlock_memory();
+}
+
+#ifdef MICRO_XRCEDDS_SERIAL
+// Opens and configures the device of the transport params passed in args, returns -1
+// on failure.
+static int open_serial_device(void * args)
+{
+  const rmw_uxrce_transport_params_t * params = (const rmw_uxrce_transport_params_t *)args;
+  speed_t speed;
+  if (!get_serial_speed(params->serial_baud_rate, &speed)) {
+    RMW_SET_ERROR_MSG("serial baud rate not supported");
+    return -1;
+  }
+
+  int fd = open(params->serial_device, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    RMW_SET_ERROR_MSG("Can not open the serial device");
+    return -1;
+  }
+
+  struct termios tty_config;
+  memset(&tty_config, 0, sizeof(tty_config));
+  if (0 == tcgetattr(fd, &tty_config)) {
+    /* Setting CONTROL OPTIONS. */
+    tty_config.c_cflag |= CREAD;          // Enable read.
+    tty_config.c_cflag |= CLOCAL;         // Set local mode.
+    tty_config.c_cflag &= ~PARENB;        // Disable parity.
+    tty_config.c_cflag &= ~CSTOPB;        // Set one stop bit.
+    tty_config.c_cflag &= ~CSIZE;         // Mask the character size bits.
+    tty_config.c_cflag |= CS8;            // Set 8 data bits.
+    if (params->serial_flow_control) {
+      tty_config.c_cflag |= CRTSCTS;      // Enable hardware flow control.
+    } else {
+      tty_config.c_cflag &= ~CRTSCTS;     // Disable hardware flow control.
+    }
+
+    /* Setting LOCAL OPTIONS. */
+    tty_config.c_lflag &= ~ICANON;        // Set non-canonical input.
+    tty_config.c_lflag &= ~ECHO;          // Disable echoing of input characters.
+    tty_config.c_lflag &= ~ECHOE;         // Disable echoing the erase character.
+    tty_config.c_lflag &= ~ISIG;          // Disable SIGINTR, SIGSUSP, SIGDSUSP
+                                          // and SIGQUIT signals.
+
+    /* Setting INPUT OPTIONS. */
+    tty_config.c_iflag &= ~IXON;          // Disable output software flow control.
+    tty_config.c_iflag &= ~IXOFF;         // Disable input software flow control.
+    tty_config.c_iflag &= ~INPCK;         // Disable parity check.
+    tty_config.c_iflag &= ~ISTRIP;        // Disable strip parity bits.
+    tty_config.c_iflag &= ~IGNBRK;        // No ignore break condition.
+    tty_config.c_iflag &= ~IGNCR;         // No ignore carrier return.
+    tty_config.c_iflag &= ~INLCR;         // No map NL to CR.
+    tty_config.c_iflag &= ~ICRNL;         // No map CR to NL.
+
+    /* Setting OUTPUT OPTIONS. */
+    tty_config.c_oflag &= ~OPOST;         // Set raw output.
+
+    /* Setting OUTPUT CHARACTERS. */
+    // The transport polls the descriptor before reading, so reads return whatever
+    // arrived instead of waiting for a minimum count or an inter-byte timeout.
+    tty_config.c_cc[VMIN] = 0;
+    tty_config.c_cc[VTIME] = 0;
+
+    /* Setting BAUD RATE. */
+    cfsetispeed(&tty_config, speed);
+    cfsetospeed(&tty_config, speed);
+
+    if (0 == tcsetattr(fd, TCSANOW, &tty_config)) {
+#ifdef __linux__
+      // USB adapters otherwise hold received bytes for their latency timer, not every
+      // driver supports it
+      struct serial_struct serial_info;
+      if (0 == ioctl(fd, TIOCGSERIAL, &serial_info)) {
+        serial_info.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial_info);
+      }
+#endif
+      return fd;
+    }
+  }
+
+  close(fd);
+  RMW_SET_ERROR_MSG("Can not configure the serial device");
+  return -1;
+}
+
+static bool open_serial_transport(CustomNode * node, const rmw_uxrce_transport_params_t * params)
+{
+#ifdef MICRO_XRCEDDS_SERIAL_MUX
+  // Nodes on the same device share it, the device settings are those of the first one
+  if (!open_serial_mux_channel(&node->transport.serial_mux, params->serial_device,
+    open_serial_device, (void *)params))
+  {
+    RMW_SET_ERROR_MSG("Can not join the serial device multiplexer");
+    return false;
+  }
+  node->comm = &node->transport.serial_mux.comm;
+  printf("Serial multiplexed mode => dev: %s - address: %u\n", params->serial_device,
+    (unsigned)node->transport.serial_mux.address);
+  return true;
+#else
+  int fd = open_serial_device((void *)params);
+  if (fd < 0) {
+    return false;
+  }
+  if (!uxr_init_serial_transport(&node->transport.serial, &node->platform.serial, fd, 0, 1)) {
+    close(fd);
+    RMW_SET_ERROR_MSG("Can not create an serial connection");
+    return false;
+  }
+  node->comm = &node->transport.serial.comm;
+  printf("Serial mode => dev: %s - baud: %u\n", params->serial_device,
+    (unsigned)params->serial_baud_rate);
+  return true;
+#endif
+}
+#endif
+
+#ifdef MICRO_XRCEDDS_TCP
+static bool open_tcp_transport(CustomNode * node, const rmw_uxrce_transport_params_t * params)
+{
+  if (!uxr_init_tcp_transport(&node->transport.tcp, &node->platform.tcp, params->agent_ip,
+    params->agent_port))
+  {
+    RMW_SET_ERROR_MSG("Can not create a tcp connection");
+    return false;
+  }
+
+  // Small XRCE messages should not wait for the acknowledgement of the previous ones
+  int fd = node->platform.tcp.poll_fd.fd;
+  int no_delay = params->tcp_no_delay ? 1 : 0;
+  bool configured = (0 == setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)));
+  if (params->tcp_send_buffer_size > 0) {
+    int send_buffer_size = (int)params->tcp_send_buffer_size;
+    configured &= (0 == setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer_size,
+      sizeof(send_buffer_size)));
+  }
+  if (!configured) {
+    uxr_close_tcp_transport(&node->transport.tcp);
+    RMW_SET_ERROR_MSG("Can not configure the tcp connection");
+    return false;
+  }
+
+  node->comm = &node->transport.tcp.comm;
+  printf("TCP mode => ip: %s - port: %hu\n", params->agent_ip, params->agent_port);
+  return true;
+}
+#endif
+
+static bool send_custom_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  CustomTransport * transport = (CustomTransport *)instance;
+  return transport->callbacks.write(transport->callbacks.args, buf, len);
+}
+
+static bool recv_custom_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  CustomTransport * transport = (CustomTransport *)instance;
+  return transport->callbacks.read(transport->callbacks.args, buf, len, timeout);
+}
+
+static uint8_t get_custom_error(void)
+{
+  return 0;
+}
+
+static bool open_custom_transport(CustomNode * node, const rmw_uxrce_custom_transport_t * callbacks)
+{
+  CustomTransport * transport = &node->transport.custom;
+  if ((callbacks->open != NULL) && !callbacks->open(callbacks->args)) {
+    RMW_SET_ERROR_MSG("Can not open the custom transport");
+    return false;
+  }
+
+  transport->callbacks = *callbacks;
+  transport->comm.instance = transport;
+  transport->comm.send_msg = send_custom_msg;
+  transport->comm.recv_msg = recv_custom_msg;
+  transport->comm.comm_error = get_custom_error;
+  transport->comm.mtu = callbacks->mtu;
+  node->comm = &transport->comm;
+  printf("Custom transport mode => mtu: %hu\n", callbacks->mtu);
+  return true;
+}
+
+static bool open_transport(CustomNode * node, const rmw_uxrce_transport_params_t * params)
+{
+  switch (params->kind) {
+#if defined(MICRO_XRCEDDS_UDP_BATCH)
+    case RMW_UXRCE_TRANSPORT_UDP:
+      if (!open_udp_batch_transport(&node->transport.udp_batch, params->agent_ip,
+        params->agent_port))
+      {
+        RMW_SET_ERROR_MSG("Can not create an udp connection");
+        return false;
+      }
+      node->comm = &node->transport.udp_batch.comm;
+      printf("UDP batch mode => ip: %s - port: %hu\n", params->agent_ip, params->agent_port);
+      return true;
+#elif defined(MICRO_XRCEDDS_UDP)
+    case RMW_UXRCE_TRANSPORT_UDP:
+#ifdef MICRO_XRCEDDS_UDP6
+      node->udp_ipv6 = is_ipv6_address(params->agent_ip);
+      if (node->udp_ipv6) {
+        if (!open_udp6_transport(&node->transport.udp6, params->agent_ip, params->agent_port)) {
+          RMW_SET_ERROR_MSG("Can not create an udp connection");
+          return false;
+        }
+        node->comm = &node->transport.udp6.comm;
+        printf("UDP mode => ip: %s - port: %hu\n", params->agent_ip, params->agent_port);
+        return true;
+      }
+#endif
+      if (!uxr_init_udp_transport(&node->transport.udp, &node->platform.udp, params->agent_ip,
+        params->agent_port))
+      {
+        RMW_SET_ERROR_MSG("Can not create an udp connection");
+        return false;
+      }
+      node->comm = &node->transport.udp.comm;
+      printf("UDP mode => ip: %s - port: %hu\n", params->agent_ip, params->agent_port);
+      return true;
+#endif
+#ifdef MICRO_XRCEDDS_SERIAL
+    case RMW_UXRCE_TRANSPORT_SERIAL:
+      return open_serial_transport(node, params);
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+    case RMW_UXRCE_TRANSPORT_TCP:
+      return open_tcp_transport(node, params);
+#endif
+#ifdef MICRO_XRCEDDS_SHM
+    case RMW_UXRCE_TRANSPORT_SHM:
+      if (!open_shm_transport(&node->transport.shm, params->shm_name)) {
+        RMW_SET_ERROR_MSG("Can not attach to the agent shared memory segment");
+        return false;
+      }
+      node->comm = &node->transport.shm.comm;
+      printf("Shared memory mode => segment: %s\n", params->shm_name);
+      return true;
+#endif
+    case RMW_UXRCE_TRANSPORT_CUSTOM:
+      return open_custom_transport(node, &params->custom);
+    default:
+      RMW_SET_ERROR_MSG("transport not supported by this build");
+      return false;
+  }
+}
+
+#ifdef MICRO_XRCEDDS_DISCOVERY
+// Replaces the agent of params with the one found, keeps it if none answers.
+static void find_agent(rmw_uxrce_transport_params_t * params)
+{
+  const char * cache_path = getenv("RMW_UXRCE_DISCOVERY_CACHE");
+  if (cache_path == NULL) {
+    cache_path = DISCOVERY_CACHE;
+  }
+
+  char agent_ip[RMW_UXRCE_ENDPOINT_MAX_LENGTH];
+  uint16_t agent_port;
+  if (discover_agent(cache_path, DISCOVERY_ADDRESS, params->agent_port, agent_ip,
+    sizeof(agent_ip), &agent_port))
+  {
+    memcpy(params->agent_ip, agent_ip, sizeof(agent_ip));
+    params->agent_port = agent_port;
+  } else {
+    printf("No agent answered the discovery probe, using %s:%hu\n", params->agent_ip,
+      params->agent_port);
+  }
+}
+#endif
+
+bool open_node_transport(CustomNode * node, const rmw_uxrce_transport_params_t * params)
+{
+#ifdef MICRO_XRCEDDS_DISCOVERY
+  rmw_uxrce_transport_params_t discovered;
+  if (params->agent_discovery && (params->kind == RMW_UXRCE_TRANSPORT_UDP)) {
+    discovered = *params;
+    find_agent(&discovered);
+    params = &discovered;
+  }
+#endif
+  node->transport_kind = params->kind;
+  node->transport_open = open_transport(node, params);
+  return node->transport_open;
+}
+
+static bool send_disconnected_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  (void)instance;
+  (void)buf;
+  (void)len;
+  return false;
+}
+
+static bool recv_disconnected_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  (void)instance;
+  (void)buf;
+  (void)len;
+  // Waits as a link without traffic would, so session loops do not spin
+  if ((timeout < 0) || (timeout > LIVELINESS_TIMEOUT_MS)) {
+    timeout = LIVELINESS_TIMEOUT_MS;
+  }
+  struct timespec pause = {timeout / 1000, (timeout % 1000) * 1000000L};
+  nanosleep(&pause, NULL);
+  return false;
+}
+
+static uint8_t get_disconnected_error(void)
+{
+  return 0;
+}
+
+static uxrCommunication disconnected_comm = {
+  .instance = NULL,
+  .send_msg = send_disconnected_msg,
+  .recv_msg = recv_disconnected_msg,
+  .comm_error = get_disconnected_error,
+  .mtu = MAX_TRANSPORT_MTU
+};
+
+void open_disconnected_transport(CustomNode * node)
+{
+  node->transport_open = false;
+  node->comm = &disconnected_comm;
+}
+
+void close_node_transport(CustomNode * node)
+{
+  if (!node->transport_open) {
+    return;
+  }
+  node->transport_open = false;
+
+  switch (node->transport_kind) {
+#if defined(MICRO_XRCEDDS_UDP_BATCH)
+    case RMW_UXRCE_TRANSPORT_UDP:
+      close_udp_batch_transport(&node->transport.udp_batch);
+      break;
+#elif defined(MICRO_XRCEDDS_UDP)
+    case RMW_UXRCE_TRANSPORT_UDP:
+#ifdef MICRO_XRCEDDS_UDP6
+      if (node->udp_ipv6) {
+        close_udp6_transport(&node->transport.udp6);
+        break;
+      }
+#endif
+      uxr_close_udp_transport(&node->transport.udp);
+      break;
+#endif
+#if defined(MICRO_XRCEDDS_SERIAL_MUX)
+    case RMW_UXRCE_TRANSPORT_SERIAL:
+      close_serial_mux_channel(&node->transport.serial_mux);
+      break;
+#elif defined(MICRO_XRCEDDS_SERIAL)
+    case RMW_UXRCE_TRANSPORT_SERIAL:
+      uxr_close_serial_transport(&node->transport.serial);
+      break;
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+    case RMW_UXRCE_TRANSPORT_TCP:
+      uxr_close_tcp_transport(&node->transport.tcp);
+      break;
+#endif
+#ifdef MICRO_XRCEDDS_SHM
+    case RMW_UXRCE_TRANSPORT_SHM:
+      close_shm_transport(&node->transport.shm);
+      break;
+#endif
+    case RMW_UXRCE_TRANSPORT_CUSTOM:
+      if (node->transport.custom.callbacks.close != NULL) {
+        node->transport.custom.callbacks.close(node->transport.custom.callbacks.args);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void flush_node_transport(CustomNode * node)
+{
+#ifdef MICRO_XRCEDDS_UDP_BATCH
+  if (node->transport_open && (node->transport_kind == RMW_UXRCE_TRANSPORT_UDP)) {
+    flush_udp_batch_transport(&node->transport.udp_batch);
+  }
+#else
+  (void)node;
+#endif
+}
@@ -0,0 +1,48 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <rmw/types.h>
+
+#include "./types.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Loads the transport of new nodes from the config defaults and the RMW_UXRCE_*
+// environment variables, unless rmw_uxrce_set_transport picked one.
+rmw_ret_t init_transport_params(void);
+void get_transport_params(rmw_uxrce_transport_params_t * params);
+
+// Opens the agent connection of the node and points node->comm at it.
+bool open_node_transport(CustomNode * node, const rmw_uxrce_transport_params_t * params);
+void close_node_transport(CustomNode * node);
+
+// Points node->comm at a link that sends and receives nothing, for nodes whose agents
+// all failed. The session stays usable until the next connection attempt.
+void open_disconnected_transport(CustomNode * node);
+
+// Sends the messages a batching transport still holds, called when the session is
+// released so nothing waits for the next session run.
+void flush_node_transport(CustomNode * node);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // TRANSPORT_H_
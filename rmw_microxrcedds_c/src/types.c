@@ -14,58 +14,137 @@
 
 #include "./types.h"  // NOLINT
 
+#include <stdint.h>
+#include <string.h>
+
 #include "./memory.h"
 
 
-void init_publisher_memory(
-  struct MemPool * memory,
-  CustomPublisher publishers[MAX_PUBLISHERS_X_NODE], size_t size)
+static size_t arena_region_size(size_t size)
 {
-  if (size > 0) {
-    link_prev(NULL, &publishers[0].mem, NULL);
-    size > 1 ? link_next(&publishers[0].mem, &publishers[1].mem, &publishers[0]) : link_next(
-      &publishers[0].mem, NULL, &publishers[0]);
-    for (unsigned int i = 1; i <= size - 1; i++) {
-      link_prev(&publishers[i - 1].mem, &publishers[i].mem, &publishers[i]);
-    }
-    link_next(&publishers[size - 1].mem, NULL, &publishers[size - 1]);
-    set_mem_pool(memory, &publishers[0].mem);
-  }
+  return (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+}
+
+static void * arena_carve(uint8_t ** cursor, size_t size)
+{
+  void * region = *cursor;
+  *cursor += arena_region_size(size);
+  return region;
 }
 
-void init_subscriber_memory(
-  struct MemPool * memory,
-  CustomSubscription subscribers[MAX_SUBSCRIPTIONS_X_NODE], size_t size)
+static size_t node_storage_size(const rmw_uxrce_limits_t * limits)
 {
-  if (size > 0) {
-    link_prev(NULL, &subscribers[0].mem, NULL);
-    size > 1 ? link_next(&subscribers[0].mem, &subscribers[1].mem, &subscribers[0]) : link_next(
-      &subscribers[0].mem, NULL, &subscribers[0]);
-    for (unsigned int i = 1; i <= size - 1; i++) {
-      link_prev(&subscribers[i - 1].mem, &subscribers[i].mem, &subscribers[i]);
-    }
-    link_next(&subscribers[size - 1].mem, NULL, &subscribers[size - 1]);
-    set_mem_pool(memory, &subscribers[0].mem);
+  size_t size = 0;
+  size += arena_region_size(limits->max_publishers_x_node * sizeof(CustomPublisher));
+  size += arena_region_size(limits->max_publishers_x_node * sizeof(struct MemLink));
+  size += arena_region_size(limits->max_subscriptions_x_node * sizeof(CustomSubscription));
+  size += arena_region_size(limits->max_subscriptions_x_node * sizeof(struct MemLink));
+  size += arena_region_size(limits->max_topics_x_node * sizeof(custom_topic_t));
+  size += arena_region_size(limits->max_topics_x_node * sizeof(struct MemLink));
+  size += arena_region_size(2 * limits->max_topics_x_node * sizeof(custom_topic_t *));
+  size += arena_region_size(limits->max_subscriptions_x_node * sizeof(uint16_t));
+  size += arena_region_size(limits->max_subscriptions_x_node * sizeof(uint8_t));
+  size += 2 * arena_region_size(MAX_TRANSPORT_MTU * limits->max_history);
+  size += limits->max_subscriptions_x_node *
+    (arena_region_size(limits->max_history_x_subscription * MAX_TRANSPORT_MTU) +
+    arena_region_size(limits->max_history_x_subscription * sizeof(size_t)));
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  size += arena_region_size(IO_QUEUE_SIZE * sizeof(IoQueueCell));
+#endif
+  return size;
+}
+
+static void init_node_storage(
+  CustomNode * node, uint8_t ** cursor,
+  const rmw_uxrce_limits_t * limits)
+{
+  node->publisher_capacity = limits->max_publishers_x_node;
+  node->publisher_info =
+    arena_carve(cursor, node->publisher_capacity * sizeof(CustomPublisher));
+  node->subscription_capacity = limits->max_subscriptions_x_node;
+  node->subscription_info =
+    arena_carve(cursor, node->subscription_capacity * sizeof(CustomSubscription));
+  node->topic_capacity = limits->max_topics_x_node;
+  node->topic_info = arena_carve(cursor, node->topic_capacity * sizeof(custom_topic_t));
+  node->topic_hash_size = 2 * limits->max_topics_x_node;
+  node->topic_hash = arena_carve(cursor, node->topic_hash_size * sizeof(custom_topic_t *));
+  node->wait_requests = arena_carve(cursor, node->subscription_capacity * sizeof(uint16_t));
+  node->wait_status = arena_carve(cursor, node->subscription_capacity * sizeof(uint8_t));
+
+  node->stream_history = limits->max_history;
+  node->input_reliable_stream_buffer =
+    arena_carve(cursor, MAX_TRANSPORT_MTU * node->stream_history);
+  node->output_reliable_stream_buffer =
+    arena_carve(cursor, MAX_TRANSPORT_MTU * node->stream_history);
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  node->publish_queue.capacity = IO_QUEUE_SIZE;
+  node->publish_queue.cells = arena_carve(cursor, IO_QUEUE_SIZE * sizeof(IoQueueCell));
+#endif
+
+  for (size_t i = 0; i < node->subscription_capacity; i++) {
+    CustomSubscription * subscription = &node->subscription_info[i];
+    subscription->history_capacity = limits->max_history_x_subscription;
+    subscription->history_buffer =
+      arena_carve(cursor, subscription->history_capacity * MAX_TRANSPORT_MTU);
+    subscription->history_length =
+      arena_carve(cursor, subscription->history_capacity * sizeof(size_t));
   }
+
+  init_mem_pool(&node->publisher_mem, node->publisher_info, sizeof(CustomPublisher),
+    arena_carve(cursor, node->publisher_capacity * sizeof(struct MemLink)),
+    node->publisher_capacity);
+  init_mem_pool(&node->subscription_mem, node->subscription_info, sizeof(CustomSubscription),
+    arena_carve(cursor, node->subscription_capacity * sizeof(struct MemLink)),
+    node->subscription_capacity);
+  init_mem_pool(&node->topic_mem, node->topic_info, sizeof(custom_topic_t),
+    arena_carve(cursor, node->topic_capacity * sizeof(struct MemLink)),
+    node->topic_capacity);
+}
+
+size_t nodes_memory_size(const rmw_uxrce_limits_t * limits)
+{
+  // The leading alignment slack lets the arena start at any address.
+  return ARENA_ALIGNMENT +
+         arena_region_size(limits->max_nodes * sizeof(CustomNode)) +
+         arena_region_size(limits->max_nodes * sizeof(struct MemLink)) +
+         limits->max_nodes * node_storage_size(limits);
+}
+
+void nodes_memory_footprint(const rmw_uxrce_limits_t * limits, rmw_uxrce_footprint_t * footprint)
+{
+  size_t history_size = limits->max_history_x_subscription;
+  footprint->node = sizeof(CustomNode) + sizeof(struct MemLink);
+  footprint->publisher = sizeof(CustomPublisher) + sizeof(struct MemLink);
+  footprint->subscription = sizeof(CustomSubscription) + sizeof(struct MemLink) +
+    history_size * (MAX_TRANSPORT_MTU + sizeof(size_t)) + sizeof(uint16_t) + sizeof(uint8_t);
+  footprint->topic = sizeof(custom_topic_t) + sizeof(struct MemLink) +
+    2 * sizeof(custom_topic_t *);
+  footprint->stream = MAX_TRANSPORT_MTU * limits->max_history;
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  footprint->publish_queue = IO_QUEUE_SIZE * sizeof(IoQueueCell);
+#else
+  footprint->publish_queue = 0;
+#endif
+  footprint->node_arena = nodes_memory_size(limits);
 }
 
-void init_nodes_memory(struct MemPool * memory, CustomNode nodes[MAX_NODES], size_t size)
+bool init_nodes_memory(
+  struct MemPool * memory, uint8_t * arena, size_t arena_size,
+  const rmw_uxrce_limits_t * limits)
 {
-  if (size > 0) {
-    link_prev(NULL, &nodes[0].mem, NULL);
-    size > 1 ? link_next(&nodes[0].mem, &nodes[1].mem, &nodes[0]) : link_next(&nodes[0].mem, NULL,
-      &nodes[0]);
-    init_publisher_memory(&nodes[0].publisher_mem, nodes[0].publisher_info, MAX_PUBLISHERS_X_NODE);
-    init_subscriber_memory(&nodes[0].subscription_mem, nodes[0].subscription_info,
-      MAX_PUBLISHERS_X_NODE);
-    for (unsigned int i = 1; i <= size - 1; i++) {
-      link_prev(&nodes[i - 1].mem, &nodes[i].mem, &nodes[i]);
-      init_publisher_memory(&nodes[i].publisher_mem, nodes[i].publisher_info,
-        MAX_PUBLISHERS_X_NODE);
-      init_subscriber_memory(&nodes[i].subscription_mem, nodes[i].subscription_info,
-        MAX_PUBLISHERS_X_NODE);
-    }
-    link_next(&nodes[size - 1].mem, NULL, &nodes[size - 1]);
-    set_mem_pool(memory, &nodes[0].mem);
+  if (arena_size < nodes_memory_size(limits)) {
+    return false;
+  }
+  memset(arena, 0, arena_size);
+
+  uint8_t * cursor = arena +
+    ((ARENA_ALIGNMENT - ((uintptr_t)arena % ARENA_ALIGNMENT)) % ARENA_ALIGNMENT);
+  CustomNode * nodes = arena_carve(&cursor, limits->max_nodes * sizeof(CustomNode));
+  struct MemLink * links = arena_carve(&cursor, limits->max_nodes * sizeof(struct MemLink));
+  init_mem_pool(memory, nodes, sizeof(CustomNode), links, limits->max_nodes);
+
+  for (size_t i = 0; i < limits->max_nodes; i++) {
+    init_node_storage(&nodes[i], &cursor, limits);
   }
+  return true;
 }
@@ -24,17 +24,35 @@
 #include "rosidl_generator_c/message_type_support_struct.h"
 #include "rosidl_typesupport_microxrcedds_shared/message_type_support.h"
 
+#include "./rmw_microxrcedds.h"
+
+#include "./io_queue.h"
+#include "./serial_mux.h"
+#include "./shm_transport.h"
+#include "./udp_batch_transport.h"
+#include "./udp6_transport.h"
 #include "./memory.h"
 #include "./config.h"
 
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+#include <pthread.h>
+#endif
+
 typedef struct custom_topic_t
 {
-  struct custom_topic_t * next_custom_topic;
-  struct custom_topic_t * prev_custom_topic;
+  struct custom_topic_t * next_in_bucket;
+  uint32_t hash;
 
   uxrObjectId topic_id;
   const message_type_support_callbacks_t * message_type_support_callbacks;
 
+  // Rendered once at creation and reused by every entity built on the topic.
+  char topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 3];
+  size_t topic_name_length;
+  size_t ros_name_offset;  // topic name as given by the user, without the ROS prefix
+  char type_name[RMW_TYPE_NAME_MAX_NAME_LENGTH + 1];
+  size_t type_name_length;
+
   bool sync_with_agent;
   int32_t usage_account;
   struct CustomNode * owner_node;
@@ -42,18 +60,30 @@ typedef struct custom_topic_t
 
 typedef struct CustomSubscription
 {
-  struct Item mem;
+  rmw_subscription_t rmw_handle;
+  char topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 1];
+
   uxrObjectId subscriber_id;
   uxrObjectId datareader_id;
   rmw_gid_t subscription_gid;
   const message_type_support_callbacks_t * type_support_callbacks;
   uxrSession * session;  // TODO(Javier) duplicated: owner_node->session
 
-  struct ucdrBuffer micro_buffer;
-  bool micro_buffer_in_use;
+  rmw_qos_profile_t qos;
+
+  // Local sample queue of history_capacity slots of MAX_TRANSPORT_MTU bytes. Keep-last
+  // overwrites the oldest sample once history_depth samples are stored, keep-all stops
+  // requesting data instead.
+  uint8_t * history_buffer;
+  size_t * history_length;
+  size_t history_capacity;
+  size_t history_head;
+  size_t history_count;
+  size_t history_depth;
 
   bool waiting_for_response;
   uint16_t subscription_request;
+  uint16_t requested_samples;
 
   uxrObjectId topic_id;  // TODO(Javier) Pending to be removed
   struct custom_topic_t * topic;
@@ -63,10 +93,13 @@ typedef struct CustomSubscription
 
 typedef struct CustomPublisher
 {
-  struct Item mem;
+  rmw_publisher_t rmw_handle;
+  char topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 1];
+
   uxrObjectId publisher_id;
   uxrObjectId datawriter_id;
   rmw_gid_t publisher_gid;
+  rmw_qos_profile_t qos;
 
   const message_type_support_callbacks_t * type_support_callbacks;
   uxrSession * session;  // TODO(Javier) duplicated: owner_node->session
@@ -77,38 +110,130 @@ typedef struct CustomPublisher
   struct CustomNode * owner_node;
 } CustomPublisher;
 
+// Application transport seen by the session, see transport.c.
+typedef struct CustomTransport
+{
+  uxrCommunication comm;
+  rmw_uxrce_custom_transport_t callbacks;
+} CustomTransport;
+
 typedef struct CustomNode
 {
-  struct Item mem;
+  rmw_node_t rmw_handle;
+  char name[RMW_NODE_NAME_MAX_NAME_LENGTH + 1];
+  char namespace_[RMW_NODE_NAME_MAX_NAME_LENGTH + 1];
+  rmw_guard_condition_t graph_guard_condition;
+
+  // Agent connection of the kind picked at creation, see transport.c.
+  rmw_uxrce_transport_kind_t transport_kind;
+#ifdef MICRO_XRCEDDS_UDP6
+  // UDP nodes with an IPv6 agent use transport.udp6
+  bool udp_ipv6;
+#endif
+  union
+  {
+#ifdef MICRO_XRCEDDS_UDP_BATCH
+    UdpBatchTransport udp_batch;
+#endif
+#ifdef MICRO_XRCEDDS_UDP
+    uxrUDPTransport udp;
+#endif
+#ifdef MICRO_XRCEDDS_UDP6
+    Udp6Transport udp6;
+#endif
+#ifdef MICRO_XRCEDDS_SERIAL
+    uxrSerialTransport serial;
+#endif
+#ifdef MICRO_XRCEDDS_SERIAL_MUX
+    SerialMuxChannel serial_mux;
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+    uxrTCPTransport tcp;
+#endif
+#ifdef MICRO_XRCEDDS_SHM
+    ShmTransport shm;
+#endif
+    CustomTransport custom;
+  } transport;
+  union
+  {
+#ifdef MICRO_XRCEDDS_UDP
+    uxrUDPPlatform udp;
+#endif
 #ifdef MICRO_XRCEDDS_SERIAL
-  uxrSerialTransport transport;
-  uxrSerialPlatform serial_platform;
-#elif defined(MICRO_XRCEDDS_UDP)
-  uxrUDPTransport transport;
-  uxrUDPPlatform udp_platform;
+    uxrSerialPlatform serial;
+#endif
+#ifdef MICRO_XRCEDDS_TCP
+    uxrTCPPlatform tcp;
 #endif
+  } platform;
+  uxrCommunication * comm;
+  // False while the node waits for an agent to answer, see failover_node_session.
+  bool transport_open;
+  // Entry of the agent list the node is connected to, or NO_AGENT.
+  size_t agent_index;
   uxrSession session;
+  uint32_t session_key;
+  size_t domain_id;
   uxrObjectId participant_id;
   struct MemPool publisher_mem;
   struct MemPool subscription_mem;
 
-  CustomPublisher publisher_info[MAX_PUBLISHERS_X_NODE];
-  CustomSubscription subscription_info[MAX_SUBSCRIPTIONS_X_NODE];
-  custom_topic_t * custom_topic_sp;
+  // Pool storage carved from the node arena, see init_nodes_memory.
+  CustomPublisher * publisher_info;
+  size_t publisher_capacity;
+  CustomSubscription * subscription_info;
+  size_t subscription_capacity;
+  custom_topic_t * topic_info;
+  size_t topic_capacity;
+  struct MemPool topic_mem;
+  custom_topic_t ** topic_hash;
+  size_t topic_hash_size;
+
+  // rmw_wait scratch, one entry per subscription
+  uint16_t * wait_requests;
+  uint8_t * wait_status;
 
   bool on_subscription;
 
+  // Best effort streams on TCP nodes, the connection already retransmits and orders.
   uxrStreamId reliable_input;
   uxrStreamId reliable_output;
 
-  uint8_t input_reliable_stream_buffer[MAX_BUFFER_SIZE];
-  uint8_t output_reliable_stream_buffer[MAX_BUFFER_SIZE];
+  uint8_t * input_reliable_stream_buffer;
+  uint8_t * output_reliable_stream_buffer;
+  size_t stream_history;
 
   uint8_t miscellaneous_temp_buffer[MAX_TRANSPORT_MTU];
 
+  // Agent liveliness, see liveliness.c.
+  bool agent_alive;
+  int64_t last_liveliness_check;
+
+#ifdef MICRO_XRCEDDS_THREAD_SAFE
+  // Session and history locks, see io_thread.c.
+  bool io_ready;
+  size_t session_waiters;
+  pthread_mutex_t session_mutex;
+  pthread_mutex_t history_mutex;
+  pthread_cond_t history_cond;
+#endif
+#ifdef MICRO_XRCEDDS_USE_IO_THREAD
+  // Session runner. The publish queue cells come from the node arena.
+  pthread_t io_thread;
+  bool io_running;
+  struct IoQueue publish_queue;
+#endif
+
   uint16_t id_gen;
 } CustomNode;
 
-void init_nodes_memory(struct MemPool * memory, CustomNode nodes[MAX_NODES], size_t size);
+#define ARENA_ALIGNMENT 16
+
+size_t nodes_memory_size(const rmw_uxrce_limits_t * limits);
+void nodes_memory_footprint(const rmw_uxrce_limits_t * limits, rmw_uxrce_footprint_t * footprint);
+bool init_nodes_memory(
+  struct MemPool * memory, uint8_t * arena, size_t arena_size,
+  const rmw_uxrce_limits_t * limits);
 
 #endif  // TYPES_H_
@@ -0,0 +1,130 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "./udp6_transport.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_UDP6
+#include <net/if.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+bool resolve_udp_address(
+  const char * ip, uint16_t port, struct sockaddr_storage * addr,
+  socklen_t * addr_length)
+{
+  char host[INET6_ADDRSTRLEN + IF_NAMESIZE + 1];
+  size_t length = strlen(ip);
+  if ((ip[0] == '[') && (length > 2) && (ip[length - 1] == ']')) {
+    ip++;
+    length -= 2;
+  }
+  if (length >= sizeof(host)) {
+    return false;
+  }
+  memcpy(host, ip, length);
+  host[length] = '\0';
+
+  char service[6];
+  snprintf(service, sizeof(service), "%hu", port);
+
+  // Numeric only, node creation never waits for name resolution
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+  struct addrinfo * result = NULL;
+  if ((getaddrinfo(host, service, &hints, &result) != 0) || (result == NULL)) {
+    return false;
+  }
+
+  bool resolved = result->ai_addrlen <= sizeof(*addr);
+  if (resolved) {
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *addr_length = (socklen_t)result->ai_addrlen;
+  }
+  freeaddrinfo(result);
+  return resolved;
+}
+
+bool is_ipv6_address(const char * ip)
+{
+  return strchr(ip, ':') != NULL;
+}
+
+static bool send_udp6_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  Udp6Transport * transport = (Udp6Transport *)instance;
+  return send(transport->fd, buf, len, 0) == (ssize_t)len;
+}
+
+static bool recv_udp6_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  Udp6Transport * transport = (Udp6Transport *)instance;
+  struct pollfd poll_fd = {transport->fd, POLLIN, 0};
+  if (poll(&poll_fd, 1, timeout) <= 0) {
+    return false;
+  }
+
+  ssize_t received = recv(transport->fd, transport->buffer, sizeof(transport->buffer), 0);
+  if (received <= 0) {
+    return false;
+  }
+  *buf = transport->buffer;
+  *len = (size_t)received;
+  return true;
+}
+
+static uint8_t get_udp6_error(void)
+{
+  return 0;
+}
+
+bool open_udp6_transport(Udp6Transport * transport, const char * ip, uint16_t port)
+{
+  struct sockaddr_storage agent_addr;
+  socklen_t agent_addr_length;
+  if (!resolve_udp_address(ip, port, &agent_addr, &agent_addr_length)) {
+    return false;
+  }
+
+  int fd = socket(agent_addr.ss_family, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  if (connect(fd, (struct sockaddr *)&agent_addr, agent_addr_length) != 0) {
+    close(fd);
+    return false;
+  }
+
+  transport->fd = fd;
+  transport->comm.instance = transport;
+  transport->comm.send_msg = send_udp6_msg;
+  transport->comm.recv_msg = recv_udp6_msg;
+  transport->comm.comm_error = get_udp6_error;
+  transport->comm.mtu = UXR_CONFIG_UDP_TRANSPORT_MTU;
+  return true;
+}
+
+void close_udp6_transport(Udp6Transport * transport)
+{
+  close(transport->fd);
+  transport->fd = -1;
+}
+
+#endif  // MICRO_XRCEDDS_UDP6
@@ -0,0 +1,61 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UDP6_TRANSPORT_H_
+#define UDP6_TRANSPORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <uxr/client/client.h>
+
+#include "./config.h"
+
+#ifdef MICRO_XRCEDDS_UDP6
+#include <sys/socket.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#ifdef MICRO_XRCEDDS_UDP6
+// Fills addr with an IPv4 or IPv6 agent address. IPv6 addresses may be enclosed in
+// brackets and link-local ones carry their scope, as in fe80::1%eth0.
+bool resolve_udp_address(
+  const char * ip, uint16_t port, struct sockaddr_storage * addr,
+  socklen_t * addr_length);
+
+// True when ip is an IPv6 address, which the client library UDP transport can not reach.
+bool is_ipv6_address(const char * ip);
+
+// UDP transport over a socket of the agent address family.
+typedef struct Udp6Transport
+{
+  uxrCommunication comm;
+  int fd;
+  uint8_t buffer[UXR_CONFIG_UDP_TRANSPORT_MTU];
+} Udp6Transport;
+
+bool open_udp6_transport(Udp6Transport * transport, const char * ip, uint16_t port);
+void close_udp6_transport(Udp6Transport * transport);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // UDP6_TRANSPORT_H_
@@ -0,0 +1,173 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// recvmmsg and sendmmsg are GNU extensions
+#define _GNU_SOURCE
+
+#include "./udp_batch_transport.h"  // NOLINT
+
+#ifdef MICRO_XRCEDDS_UDP_BATCH
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./udp6_transport.h"
+
+static int receive_batch(UdpBatchTransport * transport)
+{
+  struct mmsghdr messages[UDP_BATCH_SIZE];
+  struct iovec vectors[UDP_BATCH_SIZE];
+  memset(messages, 0, sizeof(messages));
+  for (size_t i = 0; i < UDP_BATCH_SIZE; i++) {
+    vectors[i].iov_base = transport->input[i];
+    vectors[i].iov_len = sizeof(transport->input[i]);
+    messages[i].msg_hdr.msg_iov = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int received = recvmmsg(transport->fd, messages, UDP_BATCH_SIZE, MSG_DONTWAIT, NULL);
+  transport->recv_calls++;
+  for (int i = 0; i < received; i++) {
+    transport->input_length[i] = messages[i].msg_len;
+  }
+  return received;
+}
+
+static bool drain_input(UdpBatchTransport * transport, int timeout)
+{
+  // Under load datagrams are already queued, so only wait when there are none
+  int received = receive_batch(transport);
+  if ((received <= 0) && (timeout != 0)) {
+    struct pollfd poll_fd = {transport->fd, POLLIN, 0};
+    int ready = poll(&poll_fd, 1, timeout);
+    transport->recv_calls++;
+    if (ready <= 0) {
+      return false;
+    }
+    received = receive_batch(transport);
+  }
+  if (received <= 0) {
+    return false;
+  }
+
+  transport->input_next = 0;
+  transport->input_count = (size_t)received;
+  return true;
+}
+
+void flush_udp_batch_transport(UdpBatchTransport * transport)
+{
+  struct mmsghdr messages[UDP_BATCH_SIZE];
+  struct iovec vectors[UDP_BATCH_SIZE];
+  memset(messages, 0, sizeof(messages));
+  for (size_t i = 0; i < transport->output_count; i++) {
+    vectors[i].iov_base = transport->output[i];
+    vectors[i].iov_len = transport->output_length[i];
+    messages[i].msg_hdr.msg_iov = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  size_t sent = 0;
+  while (sent < transport->output_count) {
+    int result = sendmmsg(transport->fd, &messages[sent],
+        (unsigned int)(transport->output_count - sent), 0);
+    transport->send_calls++;
+    if (result > 0) {
+      sent += (size_t)result;
+    } else if (errno != EINTR) {
+      // Lost as any datagram, reliable streams send it again
+      break;
+    }
+  }
+  transport->output_count = 0;
+}
+
+static bool send_udp_batch_msg(void * instance, const uint8_t * buf, size_t len)
+{
+  UdpBatchTransport * transport = (UdpBatchTransport *)instance;
+  if (len > UXR_CONFIG_UDP_TRANSPORT_MTU) {
+    return false;
+  }
+
+  memcpy(transport->output[transport->output_count], buf, len);
+  transport->output_length[transport->output_count] = len;
+  if (++transport->output_count == UDP_BATCH_SIZE) {
+    flush_udp_batch_transport(transport);
+  }
+  return true;
+}
+
+static bool recv_udp_batch_msg(void * instance, uint8_t ** buf, size_t * len, int timeout)
+{
+  UdpBatchTransport * transport = (UdpBatchTransport *)instance;
+  if (transport->input_next == transport->input_count) {
+    // The session only waits for replies once everything it wrote is out
+    flush_udp_batch_transport(transport);
+    if (!drain_input(transport, timeout)) {
+      return false;
+    }
+  }
+
+  *buf = transport->input[transport->input_next];
+  *len = transport->input_length[transport->input_next];
+  transport->input_next++;
+  return true;
+}
+
+static uint8_t get_udp_batch_error(void)
+{
+  return 0;
+}
+
+bool open_udp_batch_transport(UdpBatchTransport * transport, const char * ip, uint16_t port)
+{
+  struct sockaddr_storage agent_addr;
+  socklen_t agent_addr_length;
+  if (!resolve_udp_address(ip, port, &agent_addr, &agent_addr_length)) {
+    return false;
+  }
+
+  int fd = socket(agent_addr.ss_family, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  if (connect(fd, (struct sockaddr *)&agent_addr, agent_addr_length) != 0) {
+    close(fd);
+    return false;
+  }
+
+  transport->fd = fd;
+  transport->input_next = 0;
+  transport->input_count = 0;
+  transport->output_count = 0;
+  transport->recv_calls = 0;
+  transport->send_calls = 0;
+  transport->comm.instance = transport;
+  transport->comm.send_msg = send_udp_batch_msg;
+  transport->comm.recv_msg = recv_udp_batch_msg;
+  transport->comm.comm_error = get_udp_batch_error;
+  transport->comm.mtu = UXR_CONFIG_UDP_TRANSPORT_MTU;
+  return true;
+}
+
+void close_udp_batch_transport(UdpBatchTransport * transport)
+{
+  flush_udp_batch_transport(transport);
+  close(transport->fd);
+  transport->fd = -1;
+}
+
+#endif  // MICRO_XRCEDDS_UDP_BATCH
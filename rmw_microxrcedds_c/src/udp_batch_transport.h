@@ -0,0 +1,64 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UDP_BATCH_TRANSPORT_H_
+#define UDP_BATCH_TRANSPORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <uxr/client/client.h>
+
+#include "./config.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#ifdef MICRO_XRCEDDS_UDP_BATCH
+// UDP transport that moves datagrams in batches. Reads drain every pending datagram
+// with one recvmmsg into the input batch, which the session then consumes one per
+// read. Writes are queued in the output batch and leave with one sendmmsg before the
+// next read, when the batch fills up or on flush_udp_batch_transport.
+typedef struct UdpBatchTransport
+{
+  uxrCommunication comm;
+  int fd;
+
+  uint8_t input[UDP_BATCH_SIZE][UXR_CONFIG_UDP_TRANSPORT_MTU];
+  size_t input_length[UDP_BATCH_SIZE];
+  size_t input_next;
+  size_t input_count;
+
+  uint8_t output[UDP_BATCH_SIZE][UXR_CONFIG_UDP_TRANSPORT_MTU];
+  size_t output_length[UDP_BATCH_SIZE];
+  size_t output_count;
+
+  // Syscalls made, for the benchmark and the tests.
+  size_t recv_calls;
+  size_t send_calls;
+} UdpBatchTransport;
+
+bool open_udp_batch_transport(UdpBatchTransport * transport, const char * ip, uint16_t port);
+void close_udp_batch_transport(UdpBatchTransport * transport);
+void flush_udp_batch_transport(UdpBatchTransport * transport);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // UDP_BATCH_TRANSPORT_H_
@@ -24,20 +24,10 @@ static const char ros_topic_prefix[] = "rt";
 void custompublisher_clear(CustomPublisher * publisher);
 void customsubscription_clear(CustomSubscription * subscription);
 
-void rmw_delete(void * rmw_allocated_ptr)
-{
-  rmw_free(rmw_allocated_ptr);
-  rmw_allocated_ptr = NULL;
-}
-
 void rmw_node_delete(rmw_node_t * node)
 {
-  if (node->namespace_) {
-    rmw_delete((char *)node->namespace_);
-  }
-  if (node->name) {
-    rmw_delete((char *)node->name);
-  }
+  node->namespace_ = NULL;
+  node->name = NULL;
   if (node->implementation_identifier) {
     node->implementation_identifier = NULL;
   }
@@ -45,9 +35,6 @@ void rmw_node_delete(rmw_node_t * node)
     customnode_clear((CustomNode *)node->data);
     node->data = NULL;
   }
-
-  rmw_node_free(node);
-  node = NULL;
 }
 
 void rmw_publisher_delete(rmw_publisher_t * publisher)
@@ -55,9 +42,7 @@ void rmw_publisher_delete(rmw_publisher_t * publisher)
   if (publisher->implementation_identifier) {
     publisher->implementation_identifier = NULL;
   }
-  if (publisher->topic_name) {
-    rmw_delete((char *)publisher->topic_name);
-  }
+  publisher->topic_name = NULL;
   if (publisher->data) {
     CustomPublisher * custom_publisher =
       (CustomPublisher *)publisher->data;
@@ -66,14 +51,11 @@ void rmw_publisher_delete(rmw_publisher_t * publisher)
       destroy_topic(custom_publisher->topic);
     }
 
-    put_memory(&custom_publisher->owner_node->publisher_mem,
-      &custom_publisher->mem);
+    put_memory(&custom_publisher->owner_node->publisher_mem, custom_publisher);
 
     custompublisher_clear((CustomPublisher *)publisher->data);
     publisher->data = NULL;
   }
-
-  rmw_delete(publisher);
 }
 
 void custompublisher_clear(CustomPublisher * publisher)
@@ -85,12 +67,13 @@ void custompublisher_clear(CustomPublisher * publisher)
     publisher->publisher_gid.implementation_identifier = NULL;
     memset(&publisher->publisher_gid.data, 0, RMW_GID_STORAGE_SIZE);
     publisher->type_support_callbacks = NULL;
+    publisher->topic = NULL;
   }
 }
 
-void publishers_clear(CustomPublisher publishers[MAX_PUBLISHERS_X_NODE])
+void publishers_clear(CustomPublisher * publishers, size_t size)
 {
-  for (size_t i = 0; i < MAX_PUBLISHERS_X_NODE; i++) {
+  for (size_t i = 0; i < size; i++) {
     custompublisher_clear(&publishers[i]);
   }
 }
@@ -100,9 +83,7 @@ void rmw_subscription_delete(rmw_subscription_t * subscriber)
   if (subscriber->implementation_identifier) {
     subscriber->implementation_identifier = NULL;
   }
-  if (subscriber->topic_name) {
-    rmw_delete((char *)subscriber->topic_name);
-  }
+  subscriber->topic_name = NULL;
   if (subscriber->data) {
     CustomSubscription * custom_Subscription =
       (CustomSubscription *)subscriber->data;
@@ -111,13 +92,11 @@ void rmw_subscription_delete(rmw_subscription_t * subscriber)
       destroy_topic(custom_Subscription->topic);
     }
 
-    put_memory(&custom_Subscription->owner_node->subscription_mem,
-      &custom_Subscription->mem);
+    put_memory(&custom_Subscription->owner_node->subscription_mem, custom_Subscription);
 
     customsubscription_clear((CustomSubscription *)subscriber->data);
     subscriber->data = NULL;
   }
-  rmw_delete(subscriber);
 }
 
 void customsubscription_clear(CustomSubscription * subscription)
@@ -129,12 +108,13 @@ void customsubscription_clear(CustomSubscription * subscription)
     subscription->subscription_gid.implementation_identifier = NULL;
     memset(&subscription->subscription_gid.data, 0, RMW_GID_STORAGE_SIZE);
     subscription->type_support_callbacks = NULL;
+    subscription->topic = NULL;
   }
 }
 
-void subscriptions_clear(CustomSubscription subscriptions[MAX_SUBSCRIPTIONS_X_NODE])
+void subscriptions_clear(CustomSubscription * subscriptions, size_t size)
 {
-  for (size_t i = 0; i < MAX_SUBSCRIPTIONS_X_NODE; i++) {
+  for (size_t i = 0; i < size; i++) {
     customsubscription_clear(&subscriptions[i]);
   }
 }
@@ -142,231 +122,324 @@ void subscriptions_clear(CustomSubscription subscriptions[MAX_SUBSCRIPTIONS_X_NO
 void customnode_clear(CustomNode * node)
 {
   if (node) {
-    publishers_clear(node->publisher_info);
+    publishers_clear(node->publisher_info, node->publisher_capacity);
     free_mem_pool(&node->publisher_mem);
-    subscriptions_clear(node->subscription_info);
+    subscriptions_clear(node->subscription_info, node->subscription_capacity);
     free_mem_pool(&node->subscription_mem);
+    free_mem_pool(&node->topic_mem);
+    memset(node->topic_hash, 0, node->topic_hash_size * sizeof(custom_topic_t *));
+  }
+}
+
+static bool append_xml(
+  char xml[], size_t buffer_size, size_t * length, const char * fragment,
+  size_t fragment_length)
+{
+  if ((*length + fragment_length) >= buffer_size) {
+    return false;
   }
+  memcpy(&xml[*length], fragment, fragment_length);
+  *length += fragment_length;
+  xml[*length] = '\0';
+  return true;
+}
+
+static bool append_string(char xml[], size_t buffer_size, size_t * length, const char * str)
+{
+  return append_xml(xml, buffer_size, length, str, strlen(str));
 }
 
+static bool append_uint(char xml[], size_t buffer_size, size_t * length, uint32_t value)
+{
+  char digits[10];
+  size_t count = 0;
+  do {
+    digits[sizeof(digits) - 1 - count] = (char)('0' + (value % 10));
+    value /= 10;
+    count++;
+  } while (value > 0);
+  return append_xml(xml, buffer_size, length, &digits[sizeof(digits) - count], count);
+}
+
+#define APPEND_LITERAL(xml, buffer_size, length, literal) \
+  append_xml(xml, buffer_size, length, literal, sizeof(literal) - 1)
+
 int build_participant_xml(
   size_t domain_id, const char * participant_name, char xml[],
   size_t buffer_size)
 {
   (void)domain_id;
-  static const char format[] =
-    "<dds>"
-    "<participant>"
-    "<rtps>"
-    "<name>%s</name>"
-    "</rtps>"
-    "</participant>"
-    "</dds>";
-
-  int ret = snprintf(xml, buffer_size, format, participant_name);
-  if ((ret < 0) && (ret >= (int)buffer_size)) {
-    ret = 0;
-  }
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length, "<dds><participant><rtps><name>") &&
+    append_string(xml, buffer_size, &length, participant_name) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</name></rtps></participant></dds>");
 
-  return ret;
+  return ok ? (int)length : 0;
 }
 
 int build_publisher_xml(const char * publisher_name, char xml[], size_t buffer_size)
 {
-  static const char format[] = "<publisher name=\"%s\">";
-  int ret = snprintf(xml, buffer_size, format, publisher_name);
-  if ((ret < 0) && (ret >= (int)buffer_size)) {
-    ret = 0;
-  }
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length, "<publisher name=\"") &&
+    append_string(xml, buffer_size, &length, publisher_name) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "\">");
 
-  return ret;
+  return ok ? (int)length : 0;
 }
 
 int build_subscriber_xml(const char * subscriber_name, char xml[], size_t buffer_size)
 {
-  static const char format[] = "<subscriber name=\"%s\">";
-
-  int ret = snprintf(xml, buffer_size, format, subscriber_name);
-  if ((ret < 0) && (ret >= (int)buffer_size)) {
-    ret = 0;
-  }
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length, "<subscriber name=\"") &&
+    append_string(xml, buffer_size, &length, subscriber_name) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "\">");
 
-  return ret;
+  return ok ? (int)length : 0;
 }
 
 int generate_name(const uxrObjectId * id, char name[], size_t buffer_size)
 {
-  static const char format[] = "%hu_%hi";
+  size_t length = 0;
+  bool ok = append_uint(name, buffer_size, &length, id->id) &&
+    APPEND_LITERAL(name, buffer_size, &length, "_") &&
+    append_uint(name, buffer_size, &length, id->type);
 
-  int ret = snprintf(name, buffer_size, format, id->id, id->type);
-  if ((ret < 0) && (ret >= (int)buffer_size)) {
-    ret = 0;
-  }
-
-  return ret;
+  return ok ? (int)length : 0;
 }
 
 int generate_type_name(
   const message_type_support_callbacks_t * members, const char * sep, char type_name[],
   size_t buffer_size)
 {
-  static const char format[] = "%s::%s::dds_::%s_";
-
-  int ret = snprintf(type_name, buffer_size, format,
-      members->package_name_, sep, members->message_name_);
+  size_t length = 0;
+  bool ok = append_string(type_name, buffer_size, &length, members->package_name_) &&
+    APPEND_LITERAL(type_name, buffer_size, &length, "::") &&
+    append_string(type_name, buffer_size, &length, sep) &&
+    APPEND_LITERAL(type_name, buffer_size, &length, "::dds_::") &&
+    append_string(type_name, buffer_size, &length, members->message_name_) &&
+    APPEND_LITERAL(type_name, buffer_size, &length, "_");
+
+  return ok ? (int)length : 0;
+}
 
-  if ((ret < 0) && (ret >= (int)buffer_size)) {
-    ret = 0;
+int generate_topic_name(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char full_topic_name[], size_t buffer_size)
+{
+  size_t length = 0;
+  bool ok = true;
+  if (!qos_policies->avoid_ros_namespace_conventions) {
+    ok = APPEND_LITERAL(full_topic_name, buffer_size, &length, ros_topic_prefix);
   }
+  ok = ok && append_string(full_topic_name, buffer_size, &length, topic_name);
 
-  return ret;
+  return ok ? (int)length : 0;
 }
 
-int build_topic_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size)
+#ifdef MICRO_XRCEDDS_USE_BIN
+uxrQoS_t convert_qos_profile(const rmw_qos_profile_t * qos_policies)
 {
-  static const char format[] =
-    "<dds>"
-    "<topic>"
-    "<name>%s</name>"
-    "<dataType>%s</dataType>"
-    "</topic>"
-    "</dds>";
-
-  int ret = 0;
-  static char type_name_buffer[50];
-
-  if (RMW_TOPIC_NAME_MAX_NAME_LENGTH >= strlen(topic_name) &&
-    generate_type_name(members, "msg", type_name_buffer, sizeof(type_name_buffer)))
-  {
-    char full_topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 1 + sizeof(ros_topic_prefix)];
-
-    if (!qos_policies->avoid_ros_namespace_conventions) {
-      ret = snprintf(full_topic_name, sizeof(full_topic_name), "%s%s", ros_topic_prefix,
-          topic_name);
-      if ((ret < 0) && (ret >= (int)buffer_size)) {
-        return 0;
-      }
-    } else {
-      ret = snprintf(full_topic_name, sizeof(full_topic_name), "%s", topic_name);
-      if ((ret < 0) && (ret >= (int)buffer_size)) {
-        return 0;
-      }
-    }
+  uxrQoS_t qos;
+  qos.reliability = (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT) ?
+    UXR_RELIABILITY_BEST_EFFORT : UXR_RELIABILITY_RELIABLE;
+  qos.durability = (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL) ?
+    UXR_DURABILITY_TRANSIENT_LOCAL : UXR_DURABILITY_VOLATILE;
+  qos.history = (qos_policies->history == RMW_QOS_POLICY_HISTORY_KEEP_ALL) ?
+    UXR_HISTORY_KEEP_ALL : UXR_HISTORY_KEEP_LAST;
+  qos.depth = (uint16_t)(qos_policies->depth > 0 ? qos_policies->depth : 1);
+  return qos;
+}
+#endif
 
-    ret = snprintf(xml, buffer_size, format, full_topic_name, type_name_buffer);
-    if ((ret < 0) && (ret >= (int)buffer_size)) {
-      ret = 0;
+void resolve_durability_qos(rmw_qos_profile_t * qos_policies)
+{
+  // Historical samples are only kept by a keep-last writer and only delivered
+  // to reliable readers, so transient local fills in those defaults.
+  if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL) {
+    if (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_SYSTEM_DEFAULT) {
+      qos_policies->reliability = RMW_QOS_POLICY_RELIABILITY_RELIABLE;
+    }
+    if (qos_policies->history == RMW_QOS_POLICY_HISTORY_SYSTEM_DEFAULT) {
+      qos_policies->history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
     }
   }
+}
 
-  return ret;
+static bool append_topic_xml(
+  const custom_topic_t * topic, char xml[], size_t buffer_size,
+  size_t * length)
+{
+  return APPEND_LITERAL(xml, buffer_size, length, "<name>") &&
+         append_xml(xml, buffer_size, length, topic->topic_name, topic->topic_name_length) &&
+         APPEND_LITERAL(xml, buffer_size, length, "</name><dataType>") &&
+         append_xml(xml, buffer_size, length, topic->type_name, topic->type_name_length) &&
+         APPEND_LITERAL(xml, buffer_size, length, "</dataType>");
 }
 
-int build_xml(
-  const char * format, const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size)
+static bool append_history_xml(
+  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size,
+  size_t * length)
 {
-  int ret = 0;
-  static char type_name_buffer[50];
-
-  if (generate_type_name(members, "msg", type_name_buffer, sizeof(type_name_buffer))) {
-    char full_topic_name[RMW_TOPIC_NAME_MAX_NAME_LENGTH + 1 + sizeof(ros_topic_prefix)];
-    full_topic_name[0] = '\0';
-
-    if (!qos_policies->avoid_ros_namespace_conventions) {
-      ret = snprintf(full_topic_name, sizeof(full_topic_name), "%s%s", ros_topic_prefix,
-          topic_name);
-      if ((ret < 0) && (ret >= (int)buffer_size)) {
-        return 0;
-      }
-    } else {
-      ret = snprintf(full_topic_name, sizeof(full_topic_name), "%s", topic_name);
-      if ((ret < 0) && (ret >= (int)buffer_size)) {
-        return 0;
-      }
-    }
+  bool ok = true;
+  switch (qos_policies->history) {
+    case RMW_QOS_POLICY_HISTORY_KEEP_LAST:
+      ok = APPEND_LITERAL(xml, buffer_size, length,
+          "<historyQos><kind>KEEP_LAST</kind><depth>") &&
+        append_uint(xml, buffer_size, length,
+          (uint32_t)(qos_policies->depth > 0 ? qos_policies->depth : 1)) &&
+        APPEND_LITERAL(xml, buffer_size, length, "</depth></historyQos>");
+      break;
+    case RMW_QOS_POLICY_HISTORY_KEEP_ALL:
+      ok = APPEND_LITERAL(xml, buffer_size, length,
+          "<historyQos><kind>KEEP_ALL</kind></historyQos>");
+      break;
+    default:
+      break;
+  }
 
-    ret = snprintf(xml, buffer_size, format, full_topic_name, type_name_buffer);
-    if ((ret < 0) && (ret >= (int)buffer_size)) {
-      ret = 0;
-    }
+  return ok;
+}
+
+static bool append_qos_xml(
+  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size,
+  size_t * length)
+{
+  bool has_reliability =
+    (qos_policies->reliability != RMW_QOS_POLICY_RELIABILITY_SYSTEM_DEFAULT);
+  bool has_durability = (qos_policies->durability != RMW_QOS_POLICY_DURABILITY_SYSTEM_DEFAULT);
+  if (!has_reliability && !has_durability) {
+    return true;
+  }
+
+  bool ok = APPEND_LITERAL(xml, buffer_size, length, "<qos>");
+  if (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_RELIABLE) {
+    ok = ok && APPEND_LITERAL(xml, buffer_size, length,
+        "<reliability><kind>RELIABLE</kind></reliability>");
+  } else if (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT) {
+    ok = ok && APPEND_LITERAL(xml, buffer_size, length,
+        "<reliability><kind>BEST_EFFORT</kind></reliability>");
   }
+  if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL) {
+    ok = ok && APPEND_LITERAL(xml, buffer_size, length,
+        "<durability><kind>TRANSIENT_LOCAL</kind></durability>");
+  } else if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_VOLATILE) {
+    ok = ok && APPEND_LITERAL(xml, buffer_size, length,
+        "<durability><kind>VOLATILE</kind></durability>");
+  }
+  ok = ok && APPEND_LITERAL(xml, buffer_size, length, "</qos>");
 
-  return ret;
+  return ok;
 }
+
+int build_topic_xml(const custom_topic_t * topic, char xml[], size_t buffer_size)
+{
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length, "<dds><topic>") &&
+    append_topic_xml(topic, xml, buffer_size, &length) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</topic></dds>");
+
+  return ok ? (int)length : 0;
+}
+
 int build_datawriter_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size)
+  const custom_topic_t * topic, const rmw_qos_profile_t * qos_policies,
+  char xml[], size_t buffer_size)
 {
-  static const char format[] =
-    "<dds>"
-    "<data_writer>"
-    "<topic>"
-    "<kind>NO_KEY</kind>"
-    "<name>%s</name>"
-    "<dataType>%s</dataType>"
-    "</topic>"
-    "</data_writer>"
-    "</dds>";
-  return build_xml(format, topic_name, members, qos_policies, xml, buffer_size);
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length,
+      "<dds><data_writer><topic><kind>NO_KEY</kind>") &&
+    append_topic_xml(topic, xml, buffer_size, &length) &&
+    append_history_xml(qos_policies, xml, buffer_size, &length) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</topic>") &&
+    append_qos_xml(qos_policies, xml, buffer_size, &length) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</data_writer></dds>");
+
+  return ok ? (int)length : 0;
 }
 
 int build_datareader_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size)
+  const custom_topic_t * topic, const rmw_qos_profile_t * qos_policies,
+  char xml[], size_t buffer_size)
 {
-  static const char format[] =
-    "<dds>"
-    "<data_reader>"
-    "<topic>"
-    "<kind>NO_KEY</kind>"
-    "<name>%s</name>"
-    "<dataType>%s</dataType>"
-    "</topic>"
-    "</data_reader>"
-    "</dds>";
-  return build_xml(format, topic_name, members, qos_policies, xml, buffer_size);
+  size_t length = 0;
+  bool ok = APPEND_LITERAL(xml, buffer_size, &length,
+      "<dds><data_reader><topic><kind>NO_KEY</kind>") &&
+    append_topic_xml(topic, xml, buffer_size, &length) &&
+    append_history_xml(qos_policies, xml, buffer_size, &length) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</topic>") &&
+    append_qos_xml(qos_policies, xml, buffer_size, &length) &&
+    APPEND_LITERAL(xml, buffer_size, &length, "</data_reader></dds>");
+
+  return ok ? (int)length : 0;
 }
 
 bool build_participant_profile(char profile_name[], size_t buffer_size)
 {
-  static const char profile[] = "participant_profile";
-  bool ret = false;
-  if (buffer_size >= sizeof(profile)) {
-    memcpy(profile_name, profile, sizeof(profile));
-    ret = true;
-  }
-  return ret;
+  size_t length = 0;
+  return APPEND_LITERAL(profile_name, buffer_size, &length, "participant_profile");
 }
 
 bool build_topic_profile(const char * topic_name, char profile_name[], size_t buffer_size)
 {
-  const char * const format = "%s_t";
   topic_name++;
-  bool ret = false;
-  int written = snprintf(profile_name, buffer_size, format, topic_name);
-  ret = (written > 0) && (written < (int)buffer_size);
-  return ret;
+  size_t length = 0;
+  return append_string(profile_name, buffer_size, &length, topic_name) &&
+         APPEND_LITERAL(profile_name, buffer_size, &length, "_t");
+}
+
+bool build_qos_profile_suffix(
+  const rmw_qos_profile_t * qos_policies, char suffix[],
+  size_t buffer_size)
+{
+  // Policies left to the system default are not encoded, so profiles of
+  // entities created without QoS keep their plain "<topic>_p" / "<topic>_s" names.
+  size_t length = 0;
+  bool ok = true;
+  if (buffer_size > 0) {
+    suffix[0] = '\0';
+  }
+
+  if (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_RELIABLE) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__rel");
+  } else if (qos_policies->reliability == RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__be");
+  }
+
+  if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__tl");
+  } else if (qos_policies->durability == RMW_QOS_POLICY_DURABILITY_VOLATILE) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__vol");
+  }
+
+  if (qos_policies->history == RMW_QOS_POLICY_HISTORY_KEEP_LAST) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__kl") &&
+      append_uint(suffix, buffer_size, &length,
+        (uint32_t)(qos_policies->depth > 0 ? qos_policies->depth : 1));
+  } else if (qos_policies->history == RMW_QOS_POLICY_HISTORY_KEEP_ALL) {
+    ok = ok && APPEND_LITERAL(suffix, buffer_size, &length, "__ka");
+  }
+
+  return ok;
 }
 
-bool build_datawriter_profile(const char * topic_name, char profile_name[], size_t buffer_size)
+bool build_datawriter_profile(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char profile_name[], size_t buffer_size)
 {
-  const char * const format = "%s_p";
   topic_name++;
-  bool ret = false;
-  int written = snprintf(profile_name, buffer_size, format, topic_name);
-  ret = (written > 0) && (written < (int)buffer_size);
-  return ret;
+  size_t length = 0;
+  return append_string(profile_name, buffer_size, &length, topic_name) &&
+         APPEND_LITERAL(profile_name, buffer_size, &length, "_p") &&
+         build_qos_profile_suffix(qos_policies, &profile_name[length], buffer_size - length);
 }
 
-bool build_datareader_profile(const char * topic_name, char profile_name[], size_t buffer_size)
+bool build_datareader_profile(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char profile_name[], size_t buffer_size)
 {
-  const char * const format = "%s_s";
   topic_name++;
-  bool ret = false;
-  int written = snprintf(profile_name, buffer_size, format, topic_name);
-  ret = (written > 0) && (written < (int)buffer_size);
-  return ret;
+  size_t length = 0;
+  return append_string(profile_name, buffer_size, &length, topic_name) &&
+         APPEND_LITERAL(profile_name, buffer_size, &length, "_s") &&
+         build_qos_profile_suffix(qos_policies, &profile_name[length], buffer_size - length);
 }
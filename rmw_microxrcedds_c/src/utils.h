@@ -19,11 +19,22 @@
 
 #include "./types.h"
 
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
 
 // (Borja) decide wat to do with this macro.
 #define EPROS_PRINT_TRACE() ;  // printf("func %s, in file %s:%d\n", __func__, __FILE__, __LINE__);
 
-void rmw_delete(void * rmw_allocated_ptr);
+// Creation mode of node entities. Reusing sessions takes over the entities the agent
+// already holds for the node when their description matches.
+#ifdef MICRO_XRCEDDS_SESSION_REUSE
+#define ENTITY_CREATION_MODE (UXR_REUSE | UXR_REPLACE)
+#else
+#define ENTITY_CREATION_MODE UXR_REPLACE
+#endif
+
 void rmw_node_delete(rmw_node_t * node);
 void rmw_publisher_delete(rmw_publisher_t * publisher);
 void rmw_subscription_delete(rmw_subscription_t * subscriber);
@@ -35,24 +46,43 @@ int generate_type_name(
   const message_type_support_callbacks_t * members, const char * sep, char type_name[],
   size_t buffer_size);
 
+int generate_topic_name(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char full_topic_name[], size_t buffer_size);
+
+#ifdef MICRO_XRCEDDS_USE_BIN
+uxrQoS_t convert_qos_profile(const rmw_qos_profile_t * qos_policies);
+#endif
+
+void resolve_durability_qos(rmw_qos_profile_t * qos_policies);
+
 int build_participant_xml(
   size_t domain_id, const char * participant_name, char xml[],
   size_t buffer_size);
 int build_publisher_xml(const char * publisher_name, char xml[], size_t buffer_size);
 int build_subscriber_xml(const char * subscriber_name, char xml[], size_t buffer_size);
-int build_topic_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size);
+int build_topic_xml(const custom_topic_t * topic, char xml[], size_t buffer_size);
 int build_datawriter_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size);
+  const custom_topic_t * topic, const rmw_qos_profile_t * qos_policies,
+  char xml[], size_t buffer_size);
 int build_datareader_xml(
-  const char * topic_name, const message_type_support_callbacks_t * members,
-  const rmw_qos_profile_t * qos_policies, char xml[], size_t buffer_size);
+  const custom_topic_t * topic, const rmw_qos_profile_t * qos_policies,
+  char xml[], size_t buffer_size);
 
 bool build_participant_profile(char profile_name[], size_t buffer_size);
 bool build_topic_profile(const char * topic_name, char profile_name[], size_t buffer_size);
-bool build_datawriter_profile(const char * topic_name, char profile_name[], size_t buffer_size);
-bool build_datareader_profile(const char * topic_name, char profile_name[], size_t buffer_size);
+bool build_qos_profile_suffix(
+  const rmw_qos_profile_t * qos_policies, char suffix[],
+  size_t buffer_size);
+bool build_datawriter_profile(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char profile_name[], size_t buffer_size);
+bool build_datareader_profile(
+  const char * topic_name, const rmw_qos_profile_t * qos_policies,
+  char profile_name[], size_t buffer_size);
+
+#if defined(__cplusplus)
+}
+#endif
 
 #endif  // UTILS_H_
@@ -0,0 +1,226 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rosidl_typesupport_microxrcedds_shared/identifier.h>
+#include <rosidl_typesupport_microxrcedds_shared/message_type_support.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "rmw/error_handling.h"
+#include "rmw/node_security_options.h"
+#include "rmw/rmw.h"
+
+#include "./test_utils.hpp"
+
+#define MICROXRCEDDS_PADDING sizeof(uint32_t)
+
+/*
+   The test target links with -Wl,--wrap for the functions below, so every call made
+   from the rmw sources goes through these counters.
+
+   --wrap only rewrites references in the objects of this link. Allocations made inside
+   shared libraries, such as librmw, librcutils error state handling or the Micro
+   XRCE-DDS client, are not seen. This rmw_init takes no init options to install a
+   counting rcutils allocator through, so the zero allocation checks cover the rmw
+   sources only, and libraries they call must be audited on their own.
+ */
+static bool counting = false;
+static size_t allocations = 0;
+static size_t deallocations = 0;
+
+extern "C"
+{
+void * __real_rmw_allocate(size_t size);
+void __real_rmw_free(void * pointer);
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t count, size_t size);
+void * __real_realloc(void * pointer, size_t size);
+
+void * __wrap_rmw_allocate(size_t size)
+{
+  allocations += counting ? 1 : 0;
+  return __real_rmw_allocate(size);
+}
+
+void __wrap_rmw_free(void * pointer)
+{
+  deallocations += (counting && pointer) ? 1 : 0;
+  __real_rmw_free(pointer);
+}
+
+void * __wrap_malloc(size_t size)
+{
+  allocations += counting ? 1 : 0;
+  return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t count, size_t size)
+{
+  allocations += counting ? 1 : 0;
+  return __real_calloc(count, size);
+}
+
+void * __wrap_realloc(void * pointer, size_t size)
+{
+  allocations += counting ? 1 : 0;
+  return __real_realloc(pointer, size);
+}
+}
+
+static void StartCounting()
+{
+  allocations = 0;
+  deallocations = 0;
+  counting = true;
+}
+
+static size_t StopCounting()
+{
+  counting = false;
+  return allocations;
+}
+
+const char * test_message = "Allocation audit";
+
+class TestAllocation : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    #ifndef _WIN32
+    freopen("/dev/null", "w", stderr);
+    #endif
+  }
+
+  void SetUp()
+  {
+    rmw_ret_t ret = rmw_init();
+    ASSERT_EQ(ret, RMW_RET_OK);
+
+    ConfigureDummyTypeSupport(topic_type, topic_type, package_name, 0, &dummy_type_support);
+    dummy_type_support.callbacks.cdr_serialize =
+      [](const void * untyped_ros_message, ucdrBuffer * cdr) -> bool {
+        return ucdr_serialize_string(cdr, reinterpret_cast<const char *>(untyped_ros_message));
+      };
+    dummy_type_support.callbacks.cdr_deserialize =
+      [](ucdrBuffer * cdr, void * untyped_ros_message, uint8_t * raw_mem_ptr,
+        size_t raw_mem_size) -> bool {
+        bool ok = ucdr_deserialize_string(cdr, reinterpret_cast<char *>(raw_mem_ptr),
+            raw_mem_size);
+        *(reinterpret_cast<char **>(untyped_ros_message)) = reinterpret_cast<char *>(raw_mem_ptr);
+        return ok;
+      };
+    dummy_type_support.callbacks.get_serialized_size = [](const void *) -> uint32_t {
+        return MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + strlen(
+          test_message) + 8;
+      };
+    dummy_type_support.callbacks.max_serialized_size = [](bool full_bounded) -> size_t {
+        (void)full_bounded;
+        return (size_t)(MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + 1);
+      };
+
+    ConfigureDefaultQOSPolices(&dummy_qos_policies);
+  }
+
+  // Publishes one message and waits for and takes it on the subscription.
+  void RoundTrip(rmw_publisher_t * pub, rmw_subscription_t * sub, bool * taken)
+  {
+    void * subscribers[1] = {sub->data};
+    rmw_subscriptions_t subscriptions;
+    subscriptions.subscribers = subscribers;
+    subscriptions.subscriber_count = 1;
+
+    rmw_time_t wait_timeout;
+    wait_timeout.sec = 1;
+    wait_timeout.nsec = 0;
+
+    char * read_message = NULL;
+    *taken = false;
+    if (RMW_RET_OK == rmw_publish(pub, test_message) &&
+      RMW_RET_OK == rmw_wait(&subscriptions, NULL, NULL, NULL, NULL, &wait_timeout))
+    {
+      rmw_take_with_info(sub, &read_message, taken, NULL);
+    }
+  }
+
+  void Report(const char * operation, size_t count)
+  {
+    RecordProperty(operation, static_cast<int>(count));
+    std::cout << "[ ALLOCS   ] " << operation << ": " << count << std::endl;
+  }
+
+  const char * topic_type = "topic_type";
+  const char * topic_name = "allocation_topic";
+  const char * package_name = "package_name";
+
+  dummy_type_support_t dummy_type_support;
+  rmw_qos_profile_t dummy_qos_policies;
+  rmw_node_security_options_t dummy_security_options;
+};
+
+/*
+   Testing allocations per entity creation and on the publish, wait and take hot path.
+ */
+TEST_F(TestAllocation, hot_path) {
+  StartCounting();
+  rmw_node_t * node = rmw_create_node("allocation_node", "/ns", 0, &dummy_security_options);
+  Report("node_creation", StopCounting());
+  ASSERT_NE((void *)node, (void *)NULL);
+
+  StartCounting();
+  rmw_publisher_t * pub = rmw_create_publisher(node, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies);
+  Report("publisher_creation", StopCounting());
+  ASSERT_NE((void *)pub, (void *)NULL);
+
+  StartCounting();
+  rmw_subscription_t * sub = rmw_create_subscription(node, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies, true);
+  Report("subscription_creation", StopCounting());
+  ASSERT_NE((void *)sub, (void *)NULL);
+
+  // Warm up
+  bool taken = false;
+  for (size_t i = 0; i < 10; i++) {
+    RoundTrip(pub, sub, &taken);
+  }
+
+  const size_t iterations = 100;
+  size_t received = 0;
+  StartCounting();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    RoundTrip(pub, sub, &taken);
+    received += taken ? 1 : 0;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  size_t hot_path_allocations = StopCounting();
+
+  Report("hot_path", hot_path_allocations);
+  std::cout << "[ BENCH    ] publish/wait/take: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / iterations <<
+    " us per round trip, " << received << "/" << iterations << " received" << std::endl;
+
+  ASSERT_GT(received, 0u);
+  ASSERT_EQ(hot_path_allocations, 0u);
+  ASSERT_EQ(deallocations, 0u);
+
+  ASSERT_EQ(rmw_destroy_subscription(node, sub), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_publisher(node, pub), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+}
@@ -0,0 +1,173 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "./discovery.h"
+
+// Agent stand-in answering GET_INFO probes with an INFO for the same request.
+class FakeAgent
+{
+public:
+  FakeAgent()
+  : running(true)
+  {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &length);
+    port = ntohs(addr.sin_port);
+    thread = std::thread(&FakeAgent::Serve, this);
+  }
+
+  ~FakeAgent()
+  {
+    running = false;
+    thread.join();
+    close(fd);
+  }
+
+  void Serve()
+  {
+    while (running) {
+      struct pollfd poll_fd = {fd, POLLIN, 0};
+      if (poll(&poll_fd, 1, 10) <= 0) {
+        continue;
+      }
+      uint8_t probe[64];
+      struct sockaddr_in client;
+      socklen_t length = sizeof(client);
+      ssize_t received = recvfrom(fd, probe, sizeof(probe), 0,
+          reinterpret_cast<struct sockaddr *>(&client), &length);
+      if ((received < 12) || (probe[4] != 0x02)) {
+        continue;
+      }
+      const uint8_t info[] = {probe[0], 0x00, 0x00, 0x00, 0x06, 0x01, 0x06, 0x00,
+        probe[8], probe[9], 0xFF, 0xFD, 0x00, 0x00};
+      sendto(fd, info, sizeof(info), 0, reinterpret_cast<struct sockaddr *>(&client), length);
+    }
+  }
+
+  int fd;
+  uint16_t port;
+  std::atomic<bool> running;
+  std::thread thread;
+};
+
+// Loopback port nothing listens on.
+static uint16_t unused_port()
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(addr);
+  bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+  getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &length);
+  close(fd);
+  return ntohs(addr.sin_port);
+}
+
+class TestDiscovery : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    cache_path = "/tmp/test_discovery_" + std::to_string(getpid());
+    std::remove(cache_path.c_str());
+  }
+
+  void TearDown()
+  {
+    std::remove(cache_path.c_str());
+  }
+
+  std::string ReadCache()
+  {
+    std::ifstream file(cache_path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+  }
+
+  std::string cache_path;
+  char ip[64];
+  uint16_t port;
+};
+
+/*
+   Testing that a probe finds the agent answering it and nothing else.
+ */
+TEST_F(TestDiscovery, probe) {
+  FakeAgent agent;
+  ASSERT_TRUE(probe_agent_address("127.0.0.1", agent.port, 1000, ip, sizeof(ip), &port));
+  ASSERT_STREQ(ip, "127.0.0.1");
+  ASSERT_EQ(port, agent.port);
+
+  ASSERT_FALSE(probe_agent_address("127.0.0.1", unused_port(), 50, ip, sizeof(ip), &port));
+  ASSERT_FALSE(probe_agent_address("not an ip", agent.port, 50, ip, sizeof(ip), &port));
+}
+
+/*
+   Testing that the agent found is cached and tried first on the next discovery.
+ */
+TEST_F(TestDiscovery, cache) {
+  FakeAgent agent;
+  ASSERT_TRUE(discover_agent(cache_path.c_str(), "127.0.0.1", agent.port, ip, sizeof(ip),
+    &port));
+  ASSERT_EQ(port, agent.port);
+  ASSERT_EQ(ReadCache(), "127.0.0.1:" + std::to_string(agent.port));
+
+  // The probe address reaches no agent, only the cached entry does
+  ASSERT_TRUE(discover_agent(cache_path.c_str(), "127.0.0.1", unused_port(), ip, sizeof(ip),
+    &port));
+  ASSERT_EQ(port, agent.port);
+}
+
+/*
+   Testing that a stale cache entry falls back to the probe and gets replaced.
+ */
+TEST_F(TestDiscovery, stale_cache) {
+  {
+    std::ofstream file(cache_path);
+    file << "127.0.0.1:" << unused_port() << "\n";
+  }
+
+  FakeAgent agent;
+  ASSERT_TRUE(discover_agent(cache_path.c_str(), "127.0.0.1", agent.port, ip, sizeof(ip),
+    &port));
+  ASSERT_EQ(port, agent.port);
+  ASSERT_EQ(ReadCache(), "127.0.0.1:" + std::to_string(agent.port));
+
+  // Without a cache and an agent nothing is found
+  ASSERT_FALSE(discover_agent("", "127.0.0.1", unused_port(), ip, sizeof(ip), &port));
+}
@@ -0,0 +1,142 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "./io_queue.h"
+
+const size_t queue_capacity = 4;
+
+class TestIoQueue : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    init_io_queue(&queue, cells, queue_capacity);
+  }
+
+  bool Push(uint32_t value)
+  {
+    size_t position;
+    IoQueueCell * cell = io_queue_reserve(&queue, &position);
+    if (cell == NULL) {
+      return false;
+    }
+    memcpy(cell->data, &value, sizeof(value));
+    cell->length = sizeof(value);
+    io_queue_commit(cell, position);
+    return true;
+  }
+
+  bool Pop(uint32_t * value)
+  {
+    IoQueueCell * cell = io_queue_front(&queue);
+    if (cell == NULL) {
+      return false;
+    }
+    memcpy(value, cell->data, sizeof(*value));
+    io_queue_pop(&queue);
+    return true;
+  }
+
+  struct IoQueue queue;
+  IoQueueCell cells[queue_capacity];
+};
+
+/*
+   Testing FIFO order and the full and empty conditions.
+ */
+TEST_F(TestIoQueue, fifo) {
+  uint32_t value;
+  ASSERT_FALSE(Pop(&value));
+
+  for (uint32_t lap = 0; lap < 3; lap++) {
+    for (uint32_t i = 0; i < queue_capacity; i++) {
+      ASSERT_TRUE(Push(lap * 10 + i));
+    }
+    ASSERT_FALSE(Push(0));
+
+    for (uint32_t i = 0; i < queue_capacity; i++) {
+      ASSERT_TRUE(Pop(&value));
+      ASSERT_EQ(value, lap * 10 + i);
+    }
+    ASSERT_FALSE(Pop(&value));
+  }
+}
+
+/*
+   Testing that a reserved cell blocks the consumer until it is committed.
+ */
+TEST_F(TestIoQueue, reserve_before_commit) {
+  size_t first_position;
+  IoQueueCell * first = io_queue_reserve(&queue, &first_position);
+  ASSERT_NE(first, (IoQueueCell *)NULL);
+  ASSERT_TRUE(Push(2));
+
+  uint32_t value;
+  ASSERT_FALSE(Pop(&value));
+
+  uint32_t one = 1;
+  memcpy(first->data, &one, sizeof(one));
+  first->length = sizeof(one);
+  io_queue_commit(first, first_position);
+
+  ASSERT_TRUE(Pop(&value));
+  ASSERT_EQ(value, 1u);
+  ASSERT_TRUE(Pop(&value));
+  ASSERT_EQ(value, 2u);
+}
+
+/*
+   Testing concurrent producers against a single consumer.
+ */
+TEST_F(TestIoQueue, multiple_producers) {
+  const uint32_t producers = 4;
+  const uint32_t samples_x_producer = 10000;
+
+  std::vector<std::thread> threads;
+  for (uint32_t p = 0; p < producers; p++) {
+    threads.emplace_back([this, p, samples_x_producer]() {
+        for (uint32_t i = 0; i < samples_x_producer; i++) {
+          while (!Push(p * samples_x_producer + i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+  }
+
+  // Every producer sample arrives exactly once and in its producer order
+  std::vector<uint32_t> next(producers, 0);
+  uint32_t value;
+  for (uint32_t received = 0; received < producers * samples_x_producer; ) {
+    if (!Pop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t producer = value / samples_x_producer;
+    ASSERT_LT(producer, producers);
+    ASSERT_EQ(value % samples_x_producer, next[producer]);
+    next[producer]++;
+    received++;
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  ASSERT_FALSE(Pop(&value));
+}
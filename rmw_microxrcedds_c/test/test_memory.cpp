@@ -0,0 +1,118 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "./memory.h"
+
+const size_t capacity = 4;
+
+struct Element
+{
+  int value;
+};
+
+class TestMemory : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    init_mem_pool(&pool, elements, sizeof(Element), links, capacity);
+  }
+
+  size_t CountAllocated()
+  {
+    size_t count = 0;
+    for (void * element = first_allocated(&pool); element != NULL;
+      element = next_allocated(&pool, element))
+    {
+      count++;
+    }
+    return count;
+  }
+
+  Element elements[capacity];
+  MemLink links[capacity];
+  MemPool pool;
+};
+
+/*
+   Testing allocation until exhaustion and release.
+ */
+TEST_F(TestMemory, get_and_put) {
+  std::vector<Element *> taken;
+  for (size_t i = 0; i < capacity; i++) {
+    ASSERT_TRUE(has_memory(&pool));
+    Element * element = static_cast<Element *>(get_memory(&pool));
+    ASSERT_NE((void *)element, (void *)NULL);
+    ASSERT_GE(element, &elements[0]);
+    ASSERT_LT(element, &elements[capacity]);
+    taken.push_back(element);
+  }
+  ASSERT_FALSE(has_memory(&pool));
+  ASSERT_EQ(get_memory(&pool), (void *)NULL);
+  ASSERT_EQ(pool.in_use, capacity);
+  ASSERT_EQ(CountAllocated(), capacity);
+
+  // Release from the middle of the allocated list
+  put_memory(&pool, taken[1]);
+  ASSERT_EQ(pool.in_use, capacity - 1);
+  ASSERT_EQ(CountAllocated(), capacity - 1);
+
+  // The released element is reused
+  ASSERT_EQ(get_memory(&pool), (void *)taken[1]);
+
+  for (size_t i = 0; i < taken.size(); i++) {
+    put_memory(&pool, taken[i]);
+  }
+  ASSERT_EQ(pool.in_use, 0u);
+  ASSERT_EQ(first_allocated(&pool), (void *)NULL);
+}
+
+/*
+   Testing bulk reset and high-water mark.
+ */
+TEST_F(TestMemory, reset_and_high_water) {
+  get_memory(&pool);
+  void * element = get_memory(&pool);
+  get_memory(&pool);
+  put_memory(&pool, element);
+  ASSERT_EQ(pool.in_use, 2u);
+  ASSERT_EQ(pool.high_water, 3u);
+
+  free_mem_pool(&pool);
+  ASSERT_EQ(pool.in_use, 0u);
+  ASSERT_EQ(CountAllocated(), 0u);
+  ASSERT_EQ(pool.high_water, 3u);
+
+  // Every element is available again after a reset
+  for (size_t i = 0; i < capacity; i++) {
+    ASSERT_NE(get_memory(&pool), (void *)NULL);
+  }
+  ASSERT_FALSE(has_memory(&pool));
+  ASSERT_EQ(pool.high_water, capacity);
+}
+
+/*
+   Testing an empty pool.
+ */
+TEST_F(TestMemory, empty_pool) {
+  MemPool empty;
+  init_mem_pool(&empty, NULL, sizeof(Element), NULL, 0);
+  ASSERT_FALSE(has_memory(&empty));
+  ASSERT_EQ(get_memory(&empty), (void *)NULL);
+  ASSERT_EQ(first_allocated(&empty), (void *)NULL);
+}
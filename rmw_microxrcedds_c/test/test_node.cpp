@@ -20,10 +20,21 @@
 #include <rmw/validate_namespace.h>
 #include <rmw/validate_node_name.h>
 
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <memory>
 
 #include "./config.h"
+#include "./rmw_microxrcedds.h"
+#include "./types.h"
 
 #include "./test_utils.hpp"
 
@@ -120,3 +131,311 @@ TEST_F(TestNode, memory_poll) {
   }
   nodes.clear();
 }
+
+
+/*
+   Testing pooled graph guard condition
+ */
+TEST_F(TestNode, graph_guard_condition) {
+  rmw_node_security_options_t dummy_security_options;
+  rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  ASSERT_STREQ(node->name, "my_node");
+  ASSERT_STREQ(node->namespace_, "/ns");
+
+  // Repeated calls hand out the same node owned guard condition
+  const rmw_guard_condition_t * guard_condition = rmw_node_get_graph_guard_condition(node);
+  ASSERT_NE((void *)guard_condition, (void *)NULL);
+  ASSERT_EQ(guard_condition, rmw_node_get_graph_guard_condition(node));
+
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+}
+
+
+/*
+   Testing runtime entity limits
+ */
+TEST_F(TestNode, runtime_limits) {
+  rmw_uxrce_limits_t default_limits;
+  ASSERT_EQ(rmw_uxrce_get_limits(&default_limits), RMW_RET_OK);
+
+  rmw_uxrce_limits_t limits = default_limits;
+  limits.max_nodes = 1;
+  ASSERT_EQ(rmw_uxrce_set_limits(&limits), RMW_RET_OK);
+  ASSERT_EQ(rmw_init(), RMW_RET_OK);
+
+  rmw_uxrce_limits_t current_limits;
+  ASSERT_EQ(rmw_uxrce_get_limits(&current_limits), RMW_RET_OK);
+  ASSERT_EQ(current_limits.max_nodes, 1u);
+
+  rmw_node_security_options_t dummy_security_options;
+  rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  rmw_node_t * extra_node = rmw_create_node("my_node", "/ns", 0, &dummy_security_options);
+  ASSERT_EQ((void *)extra_node, (void *)NULL);
+  ASSERT_EQ(CheckErrorState(), true);
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+
+  rmw_uxrce_memory_stats_t stats;
+  ASSERT_EQ(rmw_uxrce_get_memory_stats(&stats), RMW_RET_OK);
+  ASSERT_EQ(stats.nodes_in_use, 0u);
+  ASSERT_EQ(stats.nodes_high_water, 1u);
+
+  // Zero nodes is never valid
+  limits.max_nodes = 0;
+  ASSERT_NE(rmw_uxrce_set_limits(&limits), RMW_RET_OK);
+  rmw_reset_error();
+
+  ASSERT_EQ(rmw_uxrce_set_limits(&default_limits), RMW_RET_OK);
+  ASSERT_EQ(rmw_init(), RMW_RET_OK);
+}
+
+
+/*
+   Testing the memory footprint report
+ */
+TEST_F(TestNode, footprint) {
+  rmw_uxrce_footprint_t footprint;
+  ASSERT_EQ(rmw_uxrce_get_footprint(NULL, &footprint), RMW_RET_OK);
+  ASSERT_GE(footprint.node, sizeof(CustomNode));
+  ASSERT_GE(footprint.publisher, sizeof(CustomPublisher));
+  ASSERT_GE(footprint.subscription, sizeof(CustomSubscription));
+  ASSERT_EQ(footprint.stream, (size_t)MAX_BUFFER_SIZE);
+
+  // The node arena holds every entity of every node
+  size_t entities = MAX_NODES * (footprint.node + 2 * footprint.stream + footprint.publish_queue +
+    MAX_PUBLISHERS_X_NODE * footprint.publisher +
+    MAX_SUBSCRIPTIONS_X_NODE * footprint.subscription +
+    MAX_TOPICS_X_NODE * footprint.topic);
+  ASSERT_GE(footprint.node_arena, entities);
+  ASSERT_GT(footprint.total, footprint.node_arena);
+}
+
+
+/*
+   Testing client keys across node runs
+ */
+TEST_F(TestNode, session_key) {
+  rmw_node_security_options_t security_options;
+  rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  uint32_t first_key = reinterpret_cast<CustomNode *>(node->data)->session_key;
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+
+  node = rmw_create_node("my_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  uint32_t second_key = reinterpret_cast<CustomNode *>(node->data)->session_key;
+
+  rmw_node_t * other_node = rmw_create_node("other_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)other_node, (void *)NULL);
+  ASSERT_NE(reinterpret_cast<CustomNode *>(other_node->data)->session_key, second_key);
+
+#ifdef MICRO_XRCEDDS_SESSION_REUSE
+  // A node that starts again takes over its agent session
+  ASSERT_EQ(first_key, second_key);
+#else
+  ASSERT_NE(first_key, second_key);
+#endif
+  ASSERT_EQ(rmw_destroy_node(other_node), RMW_RET_OK);
+
+  // Duplicate node names are allowed, each one keeps its own session
+  rmw_node_t * duplicate_node = rmw_create_node("my_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)duplicate_node, (void *)NULL);
+  ASSERT_NE(reinterpret_cast<CustomNode *>(duplicate_node->data)->session_key, second_key);
+
+  ASSERT_EQ(rmw_destroy_node(duplicate_node), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+}
+
+
+/*
+   Testing runtime transport selection
+ */
+TEST_F(TestNode, runtime_transport) {
+  rmw_uxrce_transport_params_t default_params;
+  ASSERT_EQ(rmw_uxrce_get_transport(&default_params), RMW_RET_OK);
+
+  // An endpoint is required for the selected kind
+  rmw_uxrce_transport_params_t params = default_params;
+  params.kind = RMW_UXRCE_TRANSPORT_UDP;
+  params.agent_port = 0;
+  ASSERT_NE(rmw_uxrce_set_transport(&params), RMW_RET_OK);
+  rmw_reset_error();
+
+  params = default_params;
+  params.kind = RMW_UXRCE_TRANSPORT_SERIAL;
+  params.serial_device[0] = '\0';
+  ASSERT_NE(rmw_uxrce_set_transport(&params), RMW_RET_OK);
+  rmw_reset_error();
+
+  // Only standard baud rates can be set
+  params = default_params;
+  params.kind = RMW_UXRCE_TRANSPORT_SERIAL;
+  params.serial_baud_rate = 123456;
+  ASSERT_NE(rmw_uxrce_set_transport(&params), RMW_RET_OK);
+  rmw_reset_error();
+
+#ifdef MICRO_XRCEDDS_TCP
+  params = default_params;
+  params.kind = RMW_UXRCE_TRANSPORT_TCP;
+  params.agent_ip[0] = '\0';
+  ASSERT_NE(rmw_uxrce_set_transport(&params), RMW_RET_OK);
+  rmw_reset_error();
+#endif
+
+  // The transport applies to nodes created after the call
+  params = default_params;
+  ASSERT_EQ(rmw_uxrce_set_transport(&params), RMW_RET_OK);
+  rmw_node_security_options_t security_options;
+  rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  ASSERT_EQ(reinterpret_cast<CustomNode *>(node->data)->transport_kind, params.kind);
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+
+  ASSERT_EQ(rmw_uxrce_get_transport(&params), RMW_RET_OK);
+  ASSERT_EQ(params.kind, default_params.kind);
+  ASSERT_STREQ(params.agent_ip, default_params.agent_ip);
+  ASSERT_EQ(params.agent_port, default_params.agent_port);
+}
+
+#ifndef _WIN32
+// Application transport that reaches the UDP agent through its own socket.
+struct UdpLink
+{
+  int fd;
+  struct sockaddr_in agent;
+  uint8_t buffer[1024];
+  size_t opened;
+  size_t closed;
+};
+
+/*
+   Testing a node on an application supplied transport.
+ */
+TEST_F(TestNode, custom_transport) {
+  rmw_uxrce_transport_params_t default_params;
+  ASSERT_EQ(rmw_uxrce_get_transport(&default_params), RMW_RET_OK);
+
+  UdpLink link;
+  memset(&link, 0, sizeof(link));
+  link.fd = -1;
+  link.agent.sin_family = AF_INET;
+  link.agent.sin_port = htons(default_params.agent_port);
+  ASSERT_EQ(inet_pton(AF_INET, default_params.agent_ip, &link.agent.sin_addr), 1);
+
+  rmw_uxrce_custom_transport_t transport;
+  memset(&transport, 0, sizeof(transport));
+  transport.args = &link;
+  transport.mtu = static_cast<uint16_t>(std::min<size_t>(512, rmw_uxrce_get_max_mtu()));
+  transport.open = [](void * args) -> bool {
+      UdpLink * link = static_cast<UdpLink *>(args);
+      link->fd = socket(AF_INET, SOCK_DGRAM, 0);
+      link->opened++;
+      return (link->fd >= 0) &&
+             (connect(link->fd, reinterpret_cast<struct sockaddr *>(&link->agent),
+             sizeof(link->agent)) == 0);
+    };
+  transport.close = [](void * args) {
+      UdpLink * link = static_cast<UdpLink *>(args);
+      close(link->fd);
+      link->closed++;
+    };
+  transport.write = [](void * args, const uint8_t * buffer, size_t length) -> bool {
+      UdpLink * link = static_cast<UdpLink *>(args);
+      return send(link->fd, buffer, length, 0) == static_cast<ssize_t>(length);
+    };
+  transport.read = [](void * args, uint8_t ** buffer, size_t * length, int timeout) -> bool {
+      UdpLink * link = static_cast<UdpLink *>(args);
+      struct pollfd poll_fd = {link->fd, POLLIN, 0};
+      if (poll(&poll_fd, 1, timeout) <= 0) {
+        return false;
+      }
+      ssize_t received = recv(link->fd, link->buffer, sizeof(link->buffer), 0);
+      if (received <= 0) {
+        return false;
+      }
+      *buffer = link->buffer;
+      *length = static_cast<size_t>(received);
+      return true;
+    };
+
+  // Both data callbacks and an MTU the stream buffers hold are required
+  rmw_uxrce_custom_transport_t invalid = transport;
+  invalid.read = NULL;
+  ASSERT_NE(rmw_uxrce_set_custom_transport(&invalid), RMW_RET_OK);
+  rmw_reset_error();
+  invalid = transport;
+  invalid.mtu = 0;
+  ASSERT_NE(rmw_uxrce_set_custom_transport(&invalid), RMW_RET_OK);
+  rmw_reset_error();
+
+  ASSERT_EQ(rmw_uxrce_set_custom_transport(&transport), RMW_RET_OK);
+  if (default_params.kind == RMW_UXRCE_TRANSPORT_UDP) {
+    rmw_node_security_options_t security_options;
+    rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &security_options);
+    ASSERT_NE((void *)node, (void *)NULL);
+    CustomNode * custom_node = reinterpret_cast<CustomNode *>(node->data);
+    ASSERT_EQ(custom_node->transport_kind, RMW_UXRCE_TRANSPORT_CUSTOM);
+    ASSERT_EQ(custom_node->comm->mtu, transport.mtu);
+    ASSERT_EQ(link.opened, 1u);
+    ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+    ASSERT_EQ(link.closed, 1u);
+  }
+
+  ASSERT_EQ(rmw_uxrce_set_transport(&default_params), RMW_RET_OK);
+}
+#endif
+
+/*
+   Testing that nodes skip the agents of the list that do not answer.
+ */
+TEST_F(TestNode, agent_list) {
+  rmw_uxrce_transport_params_t default_params;
+  ASSERT_EQ(rmw_uxrce_get_transport(&default_params), RMW_RET_OK);
+  if ((default_params.kind != RMW_UXRCE_TRANSPORT_UDP) &&
+    (default_params.kind != RMW_UXRCE_TRANSPORT_TCP))
+  {
+    return;
+  }
+
+  rmw_uxrce_agent_endpoint_t agents[MAX_AGENTS + 1];
+  memset(agents, 0, sizeof(agents));
+  for (size_t i = 0; i <= MAX_AGENTS; i++) {
+    strcpy(agents[i].ip, default_params.agent_ip);  // NOLINT
+    agents[i].port = default_params.agent_port;
+  }
+  ASSERT_NE(rmw_uxrce_set_agents(agents, MAX_AGENTS + 1, false), RMW_RET_OK);
+  rmw_reset_error();
+  agents[0].port = 0;
+  ASSERT_NE(rmw_uxrce_set_agents(agents, 2, false), RMW_RET_OK);
+  rmw_reset_error();
+
+  // Nothing listens on the first agent
+  agents[0].port = 1;
+  ASSERT_EQ(rmw_uxrce_set_agents(agents, 2, false), RMW_RET_OK);
+  rmw_node_security_options_t security_options;
+  rmw_node_t * node = rmw_create_node("my_node", "/ns", 0, &security_options);
+  ASSERT_NE((void *)node, (void *)NULL);
+  ASSERT_EQ(reinterpret_cast<CustomNode *>(node->data)->agent_index, 1u);
+
+  rmw_uxrce_agent_status_t status;
+  ASSERT_EQ(rmw_uxrce_get_agent_status(0, &status), RMW_RET_OK);
+  ASSERT_EQ(status.endpoint.port, 1);
+  ASSERT_EQ(status.nodes, 0u);
+  ASSERT_EQ(status.failures, 1u);
+  ASSERT_FALSE(status.healthy);
+  ASSERT_EQ(rmw_uxrce_get_agent_status(1, &status), RMW_RET_OK);
+  ASSERT_EQ(status.nodes, 1u);
+  ASSERT_EQ(status.failures, 0u);
+  ASSERT_TRUE(status.healthy);
+  ASSERT_NE(rmw_uxrce_get_agent_status(2, &status), RMW_RET_OK);
+  rmw_reset_error();
+
+  // The list can not change under connected nodes
+  ASSERT_NE(rmw_uxrce_set_agents(NULL, 0, false), RMW_RET_OK);
+  rmw_reset_error();
+  ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+  ASSERT_EQ(rmw_uxrce_get_agent_status(1, &status), RMW_RET_OK);
+  ASSERT_EQ(status.nodes, 0u);
+  ASSERT_EQ(rmw_uxrce_set_agents(NULL, 0, false), RMW_RET_OK);
+}
@@ -28,6 +28,7 @@
 #include "rmw/validate_node_name.h"
 
 #include "./config.h"
+#include "./rmw_microxrcedds.h"
 
 
 #include "./test_utils.hpp"
@@ -263,3 +264,43 @@ TEST_F(TestPublisher, memory_poll_shared_topic) {
     publishers.clear();
   }
 }
+
+
+#ifdef MICRO_XRCEDDS_TCP
+/*
+   Testing that TCP nodes create publishers whose requests only fit one by one in the MTU.
+ */
+TEST_F(TestPublisher, tcp_long_names) {
+  rmw_uxrce_transport_params_t params;
+  ASSERT_EQ(rmw_uxrce_get_transport(&params), RMW_RET_OK);
+  if (params.kind != RMW_UXRCE_TRANSPORT_TCP) {
+    return;
+  }
+
+  // The ids appended by ConfigureDummyTypeSupport take the names to their limits
+  std::string long_topic(RMW_TOPIC_NAME_MAX_NAME_LENGTH - 1, 't');
+  std::string long_type(59, 'y');
+  std::string long_package(RMW_TYPE_NAME_MAX_NAME_LENGTH - 75, 'p');
+
+  dummy_type_support_t dummy_type_support;
+  ConfigureDummyTypeSupport(
+    long_type.c_str(),
+    long_topic.c_str(),
+    long_package.c_str(),
+    0,
+    &dummy_type_support);
+
+  rmw_qos_profile_t dummy_qos_policies;
+  ConfigureDefaultQOSPolices(&dummy_qos_policies);
+
+  rmw_publisher_t * pub = rmw_create_publisher(
+    this->node,
+    &dummy_type_support.type_support,
+    dummy_type_support.topic_name.data(),
+    &dummy_qos_policies);
+  ASSERT_NE((void *)pub, (void *)NULL);
+
+  rmw_ret_t ret = rmw_destroy_publisher(this->node, pub);
+  ASSERT_EQ(ret, RMW_RET_OK);
+}
+#endif
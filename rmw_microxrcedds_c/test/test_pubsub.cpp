@@ -29,6 +29,8 @@
 #include "rmw/validate_namespace.h"
 #include "rmw/validate_node_name.h"
 
+#include "./config.h"
+
 #include "./test_utils.hpp"
 
 #define MICROXRCEDDS_PADDING sizeof(uint32_t)
@@ -166,3 +168,202 @@ TEST_F(TestSubscription, publish_and_receive) {
   ASSERT_EQ(taken, true);
   ASSERT_EQ(strcmp(test_parameter, ReadMesg), 0);
 }
+
+
+/*
+   Testing a late joining transient local subscription
+ */
+TEST_F(TestSubscription, transient_local_late_joiner) {
+  dummy_type_support_t dummy_type_support;
+  ConfigureDummyTypeSupport(
+    topic_type,
+    topic_type,
+    package_name,
+    id_gen++,
+    &dummy_type_support);
+
+  dummy_type_support.callbacks.cdr_serialize =
+    [](const void * untyped_ros_message, ucdrBuffer * cdr) -> bool {
+      bool ok;
+      ok = ucdr_serialize_string(cdr, reinterpret_cast<const char *>(untyped_ros_message));
+      return ok;
+    };
+  dummy_type_support.callbacks.cdr_deserialize =
+    [](ucdrBuffer * cdr, void * untyped_ros_message, uint8_t * raw_mem_ptr,
+      size_t raw_mem_size) -> bool {
+      bool ok;
+
+      ok = ucdr_deserialize_string(cdr, reinterpret_cast<char *>(raw_mem_ptr), raw_mem_size);
+      *(reinterpret_cast<char **>(untyped_ros_message)) = reinterpret_cast<char *>(raw_mem_ptr);
+
+      return ok;
+    };
+  dummy_type_support.callbacks.get_serialized_size = [](const void *) -> uint32_t {
+      return MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + strlen(
+        test_parameter) + 8;
+    };
+  dummy_type_support.callbacks.max_serialized_size = [](bool full_bounded) -> size_t {
+      return (size_t)(MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + 1);
+    };
+
+  rmw_qos_profile_t dummy_qos_policies;
+  ConfigureDefaultQOSPolices(&dummy_qos_policies);
+  dummy_qos_policies.durability = RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL;
+  dummy_qos_policies.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  dummy_qos_policies.depth = 3;
+
+  bool ignore_local_publications = true;
+
+  rmw_node_security_options_t dummy_security_options;
+
+
+  rmw_node_t * node_pub;
+  node_pub = rmw_create_node("pub_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node_pub, (void *)NULL);
+
+
+  rmw_publisher_t * pub = rmw_create_publisher(node_pub, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies);
+  ASSERT_NE((void *)pub, (void *)NULL);
+
+  // Publish before the subscription exists
+  for (size_t i = 0; i < dummy_qos_policies.depth; i++) {
+    ret = rmw_publish(pub, test_parameter);
+    ASSERT_EQ(ret, RMW_RET_OK);
+  }
+
+  rmw_node_t * node_sub;
+  node_sub = rmw_create_node("sub_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node_sub, (void *)NULL);
+
+
+  rmw_subscription_t * sub = rmw_create_subscription(node_sub, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies, ignore_local_publications);
+  ASSERT_NE((void *)sub, (void *)NULL);
+
+
+  rmw_subscriptions_t subscriptions;
+  rmw_guard_conditions_t * guard_conditions = NULL;
+  rmw_services_t * services = NULL;
+  rmw_clients_t * clients = NULL;
+  rmw_wait_set_t * wait_set = NULL;
+  rmw_time_t wait_timeout;
+  wait_timeout.sec = 1;
+  wait_timeout.nsec = 0;
+
+  size_t received = 0;
+  for (size_t i = 0; i < 10 && received < dummy_qos_policies.depth; i++) {
+    void * subscriber = sub->data;
+    subscriptions.subscribers = &subscriber;
+    subscriptions.subscriber_count = 1;
+
+    ret = rmw_wait(
+      &subscriptions,
+      guard_conditions,
+      services,
+      clients,
+      wait_set,
+      &wait_timeout
+      );
+    if (ret != RMW_RET_OK) {
+      continue;
+    }
+
+    char * ReadMesg;
+    bool taken = true;
+    while (taken) {
+      ret = rmw_take_with_info(
+        sub,
+        &ReadMesg,
+        &taken,
+        NULL
+        );
+      ASSERT_EQ(ret, RMW_RET_OK);
+      if (taken) {
+        ASSERT_EQ(strcmp(test_parameter, ReadMesg), 0);
+        received++;
+      }
+    }
+  }
+  ASSERT_EQ(received, dummy_qos_policies.depth);
+}
+
+/*
+   Testing that the agent liveliness probes leave the entities working
+ */
+TEST_F(TestSubscription, publish_across_liveliness_checks) {
+  if (LIVELINESS_PERIOD_MS == 0) {
+    return;
+  }
+
+  dummy_type_support_t dummy_type_support;
+  ConfigureDummyTypeSupport(
+    topic_type,
+    topic_type,
+    package_name,
+    id_gen++,
+    &dummy_type_support);
+
+  dummy_type_support.callbacks.cdr_serialize =
+    [](const void * untyped_ros_message, ucdrBuffer * cdr) -> bool {
+      return ucdr_serialize_string(cdr, reinterpret_cast<const char *>(untyped_ros_message));
+    };
+  dummy_type_support.callbacks.cdr_deserialize =
+    [](ucdrBuffer * cdr, void * untyped_ros_message, uint8_t * raw_mem_ptr,
+      size_t raw_mem_size) -> bool {
+      bool ok = ucdr_deserialize_string(cdr, reinterpret_cast<char *>(raw_mem_ptr), raw_mem_size);
+      *(reinterpret_cast<char **>(untyped_ros_message)) = reinterpret_cast<char *>(raw_mem_ptr);
+      return ok;
+    };
+  dummy_type_support.callbacks.get_serialized_size = [](const void *) -> uint32_t {
+      return MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + strlen(
+        test_parameter) + 8;
+    };
+
+  rmw_qos_profile_t dummy_qos_policies;
+  ConfigureDefaultQOSPolices(&dummy_qos_policies);
+
+  rmw_node_security_options_t dummy_security_options;
+  rmw_node_t * node_pub = rmw_create_node("pub_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node_pub, (void *)NULL);
+  rmw_node_t * node_sub = rmw_create_node("sub_node", "/ns", 0, &dummy_security_options);
+  ASSERT_NE((void *)node_sub, (void *)NULL);
+
+  rmw_publisher_t * pub = rmw_create_publisher(node_pub, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies);
+  ASSERT_NE((void *)pub, (void *)NULL);
+  rmw_subscription_t * sub = rmw_create_subscription(node_sub, &dummy_type_support.type_support,
+      topic_name, &dummy_qos_policies, true);
+  ASSERT_NE((void *)sub, (void *)NULL);
+
+  rmw_time_t wait_timeout;
+  wait_timeout.sec = 1;
+  wait_timeout.nsec = 0;
+
+  for (size_t round = 0; round < 2; round++) {
+    // Idle long enough for the next publish and wait to probe the agent
+    std::this_thread::sleep_for(std::chrono::milliseconds(LIVELINESS_PERIOD_MS + 10));
+
+    ret = rmw_publish(pub, test_parameter);
+    ASSERT_EQ(ret, RMW_RET_OK);
+
+    rmw_subscriptions_t subscriptions;
+    void * subscriber = sub->data;
+    subscriptions.subscribers = &subscriber;
+    subscriptions.subscriber_count = 1;
+    ret = rmw_wait(&subscriptions, NULL, NULL, NULL, NULL, &wait_timeout);
+    ASSERT_EQ(ret, RMW_RET_OK);
+
+    char * ReadMesg;
+    bool taken;
+    ret = rmw_take_with_info(sub, &ReadMesg, &taken, NULL);
+    ASSERT_EQ(ret, RMW_RET_OK);
+    ASSERT_EQ(taken, true);
+    ASSERT_EQ(strcmp(test_parameter, ReadMesg), 0);
+  }
+
+  ASSERT_EQ(rmw_destroy_subscription(node_sub, sub), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_publisher(node_pub, pub), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_node(node_sub), RMW_RET_OK);
+  ASSERT_EQ(rmw_destroy_node(node_pub), RMW_RET_OK);
+}
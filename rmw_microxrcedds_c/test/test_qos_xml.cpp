@@ -0,0 +1,228 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "./utils.h"
+
+// Fragments every QoS policy value adds to the entity XML and to the ref profile name.
+struct PolicyCase
+{
+  std::string history_xml;
+  std::string qos_xml;
+  std::string suffix;
+};
+
+static const rmw_qos_reliability_policy_t reliabilities[] = {
+  RMW_QOS_POLICY_RELIABILITY_SYSTEM_DEFAULT,
+  RMW_QOS_POLICY_RELIABILITY_RELIABLE,
+  RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT
+};
+static const PolicyCase reliability_cases[] = {
+  {"", "", ""},
+  {"", "<reliability><kind>RELIABLE</kind></reliability>", "__rel"},
+  {"", "<reliability><kind>BEST_EFFORT</kind></reliability>", "__be"}
+};
+
+static const rmw_qos_durability_policy_t durabilities[] = {
+  RMW_QOS_POLICY_DURABILITY_SYSTEM_DEFAULT,
+  RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL,
+  RMW_QOS_POLICY_DURABILITY_VOLATILE
+};
+static const PolicyCase durability_cases[] = {
+  {"", "", ""},
+  {"", "<durability><kind>TRANSIENT_LOCAL</kind></durability>", "__tl"},
+  {"", "<durability><kind>VOLATILE</kind></durability>", "__vol"}
+};
+
+static const rmw_qos_history_policy_t histories[] = {
+  RMW_QOS_POLICY_HISTORY_SYSTEM_DEFAULT,
+  RMW_QOS_POLICY_HISTORY_KEEP_LAST,
+  RMW_QOS_POLICY_HISTORY_KEEP_ALL
+};
+static const PolicyCase history_cases[] = {
+  {"", "", ""},
+  {"<historyQos><kind>KEEP_LAST</kind><depth>5</depth></historyQos>", "", "__kl5"},
+  {"<historyQos><kind>KEEP_ALL</kind></historyQos>", "", "__ka"}
+};
+
+class TestQosXml : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    memset(&topic, 0, sizeof(topic));
+    strcpy(topic.topic_name, "rt/chatter");  // NOLINT
+    topic.topic_name_length = strlen(topic.topic_name);
+    strcpy(topic.type_name, "std_msgs::msg::dds_::String_");  // NOLINT
+    topic.type_name_length = strlen(topic.type_name);
+
+    memset(&qos, 0, sizeof(qos));
+    qos.depth = 5;
+  }
+
+  std::string TopicXml()
+  {
+    return "<topic><kind>NO_KEY</kind><name>rt/chatter</name>"
+           "<dataType>std_msgs::msg::dds_::String_</dataType>";
+  }
+
+  custom_topic_t topic;
+  rmw_qos_profile_t qos;
+  char buffer[1024];
+};
+
+/*
+   Testing the datawriter and datareader XML of a typical reliable transient local topic.
+ */
+TEST_F(TestQosXml, entity_xml) {
+  qos.reliability = RMW_QOS_POLICY_RELIABILITY_RELIABLE;
+  qos.durability = RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL;
+  qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+
+  const char * writer_xml =
+    "<dds><data_writer><topic><kind>NO_KEY</kind><name>rt/chatter</name>"
+    "<dataType>std_msgs::msg::dds_::String_</dataType>"
+    "<historyQos><kind>KEEP_LAST</kind><depth>5</depth></historyQos></topic>"
+    "<qos><reliability><kind>RELIABLE</kind></reliability>"
+    "<durability><kind>TRANSIENT_LOCAL</kind></durability></qos></data_writer></dds>";
+  ASSERT_EQ(build_datawriter_xml(&topic, &qos, buffer, sizeof(buffer)),
+    static_cast<int>(strlen(writer_xml)));
+  ASSERT_STREQ(buffer, writer_xml);
+
+  // Without policies the reader only names its topic
+  memset(&qos, 0, sizeof(qos));
+  const char * reader_xml =
+    "<dds><data_reader><topic><kind>NO_KEY</kind><name>rt/chatter</name>"
+    "<dataType>std_msgs::msg::dds_::String_</dataType></topic></data_reader></dds>";
+  ASSERT_EQ(build_datareader_xml(&topic, &qos, buffer, sizeof(buffer)),
+    static_cast<int>(strlen(reader_xml)));
+  ASSERT_STREQ(buffer, reader_xml);
+
+  // A keep last depth of 0 is sent as 1
+  qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  ASSERT_GT(build_datareader_xml(&topic, &qos, buffer, sizeof(buffer)), 0);
+  ASSERT_NE(strstr(buffer, "<depth>1</depth>"), nullptr);
+}
+
+/*
+   Testing the XML and ref profile names of every reliability, durability and history.
+ */
+TEST_F(TestQosXml, policy_combinations) {
+  for (size_t r = 0; r < 3; r++) {
+    for (size_t d = 0; d < 3; d++) {
+      for (size_t h = 0; h < 3; h++) {
+        qos.reliability = reliabilities[r];
+        qos.durability = durabilities[d];
+        qos.history = histories[h];
+        SCOPED_TRACE("reliability " + std::to_string(r) + ", durability " +
+          std::to_string(d) + ", history " + std::to_string(h));
+
+        std::string qos_xml = reliability_cases[r].qos_xml + durability_cases[d].qos_xml;
+        if (!qos_xml.empty()) {
+          qos_xml = "<qos>" + qos_xml + "</qos>";
+        }
+        std::string topic_xml = TopicXml() + history_cases[h].history_xml + "</topic>";
+        std::string suffix = reliability_cases[r].suffix + durability_cases[d].suffix +
+          history_cases[h].suffix;
+
+        ASSERT_GT(build_datawriter_xml(&topic, &qos, buffer, sizeof(buffer)), 0);
+        ASSERT_EQ(std::string(buffer),
+          "<dds><data_writer>" + topic_xml + qos_xml + "</data_writer></dds>");
+        ASSERT_GT(build_datareader_xml(&topic, &qos, buffer, sizeof(buffer)), 0);
+        ASSERT_EQ(std::string(buffer),
+          "<dds><data_reader>" + topic_xml + qos_xml + "</data_reader></dds>");
+
+        ASSERT_TRUE(build_qos_profile_suffix(&qos, buffer, sizeof(buffer)));
+        ASSERT_EQ(std::string(buffer), suffix);
+        ASSERT_TRUE(build_datawriter_profile("/chatter", &qos, buffer, sizeof(buffer)));
+        ASSERT_EQ(std::string(buffer), "chatter_p" + suffix);
+        ASSERT_TRUE(build_datareader_profile("/chatter", &qos, buffer, sizeof(buffer)));
+        ASSERT_EQ(std::string(buffer), "chatter_s" + suffix);
+      }
+    }
+  }
+}
+
+/*
+   Testing that the builders fill a buffer that fits exactly and fail one byte short.
+ */
+TEST_F(TestQosXml, buffer_capacity) {
+  // "participant_profile" and its terminator
+  ASSERT_TRUE(build_participant_profile(buffer, 20));
+  ASSERT_STREQ(buffer, "participant_profile");
+  ASSERT_FALSE(build_participant_profile(buffer, 19));
+
+  uxrObjectId id = {65535, 255};
+  ASSERT_EQ(generate_name(&id, buffer, 10), 9);
+  ASSERT_STREQ(buffer, "65535_255");
+  ASSERT_EQ(generate_name(&id, buffer, 9), 0);
+  id.id = 0;
+  id.type = 0;
+  ASSERT_EQ(generate_name(&id, buffer, sizeof(buffer)), 3);
+  ASSERT_STREQ(buffer, "0_0");
+
+  // The widest number written is a UINT32_MAX depth
+  qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  qos.depth = UINT32_MAX;
+  ASSERT_TRUE(build_qos_profile_suffix(&qos, buffer, 15));
+  ASSERT_STREQ(buffer, "__kl4294967295");
+  ASSERT_FALSE(build_qos_profile_suffix(&qos, buffer, 14));
+
+  int length = build_datawriter_xml(&topic, &qos, buffer, sizeof(buffer));
+  ASSERT_GT(length, 0);
+  ASSERT_NE(strstr(buffer, "<depth>4294967295</depth>"), nullptr);
+  std::string xml(buffer);
+  ASSERT_EQ(build_datawriter_xml(&topic, &qos, buffer, length + 1), length);
+  ASSERT_EQ(std::string(buffer), xml);
+  ASSERT_EQ(build_datawriter_xml(&topic, &qos, buffer, length), 0);
+  ASSERT_EQ(build_datareader_xml(&topic, &qos, buffer, 1), 0);
+}
+
+#ifdef MICRO_XRCEDDS_USE_BIN
+/*
+   Testing the rmw QoS to binary entity QoS mapping.
+ */
+TEST_F(TestQosXml, bin_qos) {
+  // System defaults map to a reliable, volatile, keep last 1 entity
+  memset(&qos, 0, sizeof(qos));
+  uxrQoS_t bin_qos = convert_qos_profile(&qos);
+  ASSERT_EQ(bin_qos.reliability, UXR_RELIABILITY_RELIABLE);
+  ASSERT_EQ(bin_qos.durability, UXR_DURABILITY_VOLATILE);
+  ASSERT_EQ(bin_qos.history, UXR_HISTORY_KEEP_LAST);
+  ASSERT_EQ(bin_qos.depth, 1u);
+
+  qos.reliability = RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT;
+  qos.durability = RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL;
+  qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  qos.depth = 7;
+  bin_qos = convert_qos_profile(&qos);
+  ASSERT_EQ(bin_qos.reliability, UXR_RELIABILITY_BEST_EFFORT);
+  ASSERT_EQ(bin_qos.durability, UXR_DURABILITY_TRANSIENT_LOCAL);
+  ASSERT_EQ(bin_qos.history, UXR_HISTORY_KEEP_LAST);
+  ASSERT_EQ(bin_qos.depth, 7u);
+
+  qos.reliability = RMW_QOS_POLICY_RELIABILITY_RELIABLE;
+  qos.durability = RMW_QOS_POLICY_DURABILITY_VOLATILE;
+  qos.history = RMW_QOS_POLICY_HISTORY_KEEP_ALL;
+  bin_qos = convert_qos_profile(&qos);
+  ASSERT_EQ(bin_qos.reliability, UXR_RELIABILITY_RELIABLE);
+  ASSERT_EQ(bin_qos.durability, UXR_DURABILITY_VOLATILE);
+  ASSERT_EQ(bin_qos.history, UXR_HISTORY_KEEP_ALL);
+}
+#endif
@@ -0,0 +1,180 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+#include "./serial_mux.h"
+
+const char * device_name = "/dev/test_uart";
+
+// Pseudo terminal standing for the UART, the master side is the agent.
+struct FakeUart
+{
+  int master;
+  int slave;
+  size_t opened;
+};
+
+static int open_fake_uart(void * args)
+{
+  FakeUart * uart = static_cast<FakeUart *>(args);
+  uart->opened++;
+  return uart->slave;
+}
+
+class TestSerialMux : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    uart.master = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_GE(uart.master, 0);
+    ASSERT_EQ(grantpt(uart.master), 0);
+    ASSERT_EQ(unlockpt(uart.master), 0);
+    uart.slave = open(ptsname(uart.master), O_RDWR | O_NOCTTY);
+    ASSERT_GE(uart.slave, 0);
+    uart.opened = 0;
+
+    struct termios raw;
+    ASSERT_EQ(tcgetattr(uart.slave, &raw), 0);
+    cfmakeraw(&raw);
+    ASSERT_EQ(tcsetattr(uart.slave, TCSANOW, &raw), 0);
+
+    ASSERT_TRUE(open_serial_mux_channel(&first, device_name, open_fake_uart, &uart));
+    ASSERT_TRUE(open_serial_mux_channel(&second, device_name, open_fake_uart, &uart));
+  }
+
+  void TearDown()
+  {
+    close_serial_mux_channel(&second);
+    close_serial_mux_channel(&first);
+    close(uart.master);
+  }
+
+  void AgentSend(const uint8_t * payload, size_t length, uint8_t dst)
+  {
+    uint8_t frame[1024];
+    size_t frame_length = serial_mux_frame(payload, length, 0, dst, frame, sizeof(frame));
+    ASSERT_GT(frame_length, 0u);
+    ASSERT_EQ(write(uart.master, frame, frame_length), static_cast<ssize_t>(frame_length));
+  }
+
+  std::vector<uint8_t> AgentReceive(size_t length)
+  {
+    std::vector<uint8_t> received(length);
+    size_t position = 0;
+    struct pollfd poll_fd = {uart.master, POLLIN, 0};
+    while ((position < length) && (poll(&poll_fd, 1, 1000) > 0)) {
+      ssize_t result = read(uart.master, &received[position], length - position);
+      if (result <= 0) {
+        break;
+      }
+      position += static_cast<size_t>(result);
+    }
+    received.resize(position);
+    return received;
+  }
+
+  FakeUart uart;
+  SerialMuxChannel first;
+  SerialMuxChannel second;
+};
+
+/*
+   Testing that both sessions share the device with their own address.
+ */
+TEST_F(TestSerialMux, shared_device) {
+  ASSERT_EQ(uart.opened, 1u);
+  ASSERT_NE(first.address, second.address);
+  ASSERT_NE(first.address, 0);
+  ASSERT_NE(second.address, 0);
+}
+
+/*
+   Testing that frames read by one session reach the session they are addressed to.
+ */
+TEST_F(TestSerialMux, dispatch) {
+  const uint8_t to_second[] = {2, 2, 2};
+  const uint8_t to_first[] = {1, 1};
+  AgentSend(to_second, sizeof(to_second), second.address);
+  AgentSend(to_first, sizeof(to_first), first.address);
+
+  uint8_t * buffer;
+  size_t length;
+  ASSERT_TRUE(first.comm.recv_msg(&first, &buffer, &length, 1000));
+  ASSERT_EQ(length, sizeof(to_first));
+  ASSERT_EQ(memcmp(buffer, to_first, length), 0);
+
+  // Already queued by the first session read
+  ASSERT_TRUE(second.comm.recv_msg(&second, &buffer, &length, 0));
+  ASSERT_EQ(length, sizeof(to_second));
+  ASSERT_EQ(memcmp(buffer, to_second, length), 0);
+
+  ASSERT_FALSE(first.comm.recv_msg(&first, &buffer, &length, 10));
+  ASSERT_FALSE(second.comm.recv_msg(&second, &buffer, &length, 10));
+}
+
+/*
+   Testing that written frames carry the session address and escape the flag octets.
+ */
+TEST_F(TestSerialMux, framing) {
+  const uint8_t payload[] = {0x7E, 0x01, 0x7D, 0x20};
+  ASSERT_TRUE(second.comm.send_msg(&second, payload, sizeof(payload)));
+
+  uint8_t expected[64];
+  size_t expected_length = serial_mux_frame(payload, sizeof(payload), second.address, 0,
+      expected, sizeof(expected));
+  ASSERT_GT(expected_length, sizeof(payload) + 7);
+  std::vector<uint8_t> received = AgentReceive(expected_length);
+  ASSERT_EQ(received.size(), expected_length);
+  ASSERT_EQ(memcmp(received.data(), expected, expected_length), 0);
+  ASSERT_EQ(received[1], second.address);
+
+  // The escaped payload is read back as sent
+  AgentSend(payload, sizeof(payload), first.address);
+  uint8_t * buffer;
+  size_t length;
+  ASSERT_TRUE(first.comm.recv_msg(&first, &buffer, &length, 1000));
+  ASSERT_EQ(length, sizeof(payload));
+  ASSERT_EQ(memcmp(buffer, payload, length), 0);
+}
+
+/*
+   Testing that frames with a wrong CRC are dropped.
+ */
+TEST_F(TestSerialMux, corrupted_frame) {
+  const uint8_t payload[] = {5, 6, 7};
+  uint8_t frame[64];
+  size_t frame_length = serial_mux_frame(payload, sizeof(payload), 0, first.address, frame,
+      sizeof(frame));
+  frame[frame_length - 1] ^= 0x01;
+  ASSERT_EQ(write(uart.master, frame, frame_length), static_cast<ssize_t>(frame_length));
+
+  uint8_t * buffer;
+  size_t length;
+  ASSERT_FALSE(first.comm.recv_msg(&first, &buffer, &length, 50));
+
+  AgentSend(payload, sizeof(payload), first.address);
+  ASSERT_TRUE(first.comm.recv_msg(&first, &buffer, &length, 1000));
+  ASSERT_EQ(length, sizeof(payload));
+}
@@ -0,0 +1,127 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "./shm_transport.h"
+
+const size_t slot_count = 2;
+const size_t ring_size = 256;
+
+class TestShmTransport : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    name = "/rmw_uxrce_test_" + std::to_string(getpid());
+    ASSERT_TRUE(create_shm_endpoint(&endpoint, name.c_str(), slot_count, ring_size));
+    memset(&client, 0, sizeof(client));
+    ASSERT_TRUE(open_shm_transport(&client, name.c_str()));
+  }
+
+  void TearDown()
+  {
+    close_shm_transport(&client);
+    destroy_shm_endpoint(&endpoint);
+  }
+
+  std::string name;
+  ShmEndpoint endpoint;
+  ShmTransport client;
+};
+
+/*
+   Testing messages in both directions between a client and the endpoint.
+ */
+TEST_F(TestShmTransport, exchange) {
+  const uint8_t request[] = "request";
+  ASSERT_TRUE(client.comm.send_msg(client.comm.instance, request, sizeof(request)));
+  ASSERT_TRUE(shm_endpoint_slot_in_use(&endpoint, client.slot_index));
+
+  uint8_t buffer[ring_size];
+  size_t length;
+  ASSERT_TRUE(shm_endpoint_read(&endpoint, client.slot_index, buffer, sizeof(buffer), &length));
+  ASSERT_EQ(length, sizeof(request));
+  ASSERT_EQ(memcmp(buffer, request, length), 0);
+  ASSERT_FALSE(shm_endpoint_read(&endpoint, client.slot_index, buffer, sizeof(buffer), &length));
+
+  const uint8_t reply[] = "reply";
+  ASSERT_TRUE(shm_endpoint_write(&endpoint, client.slot_index, reply, sizeof(reply)));
+  uint8_t * received;
+  ASSERT_TRUE(client.comm.recv_msg(client.comm.instance, &received, &length, 0));
+  ASSERT_EQ(length, sizeof(reply));
+  ASSERT_EQ(memcmp(received, reply, length), 0);
+}
+
+/*
+   Testing messages that wrap around the end of the ring and a full ring.
+ */
+TEST_F(TestShmTransport, wrap_around) {
+  uint8_t message[100];
+  uint8_t buffer[ring_size];
+  size_t length;
+  for (uint8_t i = 0; i < 20; i++) {
+    memset(message, i, sizeof(message));
+    ASSERT_TRUE(client.comm.send_msg(client.comm.instance, message, sizeof(message)));
+    ASSERT_TRUE(shm_endpoint_read(&endpoint, client.slot_index, buffer, sizeof(buffer), &length));
+    ASSERT_EQ(length, sizeof(message));
+    ASSERT_EQ(memcmp(buffer, message, length), 0);
+  }
+
+  ASSERT_TRUE(client.comm.send_msg(client.comm.instance, message, sizeof(message)));
+  ASSERT_TRUE(client.comm.send_msg(client.comm.instance, message, sizeof(message)));
+  ASSERT_FALSE(client.comm.send_msg(client.comm.instance, message, sizeof(message)));
+}
+
+/*
+   Testing that reading an empty ring gives up after the timeout.
+ */
+TEST_F(TestShmTransport, timeout) {
+  uint8_t * received;
+  size_t length;
+  ASSERT_FALSE(client.comm.recv_msg(client.comm.instance, &received, &length, 0));
+  ASSERT_FALSE(client.comm.recv_msg(client.comm.instance, &received, &length, 10));
+}
+
+/*
+   Testing that every client gets its own slot until none is left.
+ */
+TEST_F(TestShmTransport, slots) {
+  ShmTransport second;
+  memset(&second, 0, sizeof(second));
+  ASSERT_TRUE(open_shm_transport(&second, name.c_str()));
+  ASSERT_NE(second.slot_index, client.slot_index);
+
+  ShmTransport third;
+  memset(&third, 0, sizeof(third));
+  ASSERT_FALSE(open_shm_transport(&third, name.c_str()));
+
+  // Messages of one client never reach the other
+  const uint8_t message[] = "second";
+  ASSERT_TRUE(second.comm.send_msg(second.comm.instance, message, sizeof(message)));
+  uint8_t buffer[ring_size];
+  size_t length;
+  ASSERT_FALSE(shm_endpoint_read(&endpoint, client.slot_index, buffer, sizeof(buffer), &length));
+  ASSERT_TRUE(shm_endpoint_read(&endpoint, second.slot_index, buffer, sizeof(buffer), &length));
+
+  close_shm_transport(&second);
+  ASSERT_FALSE(shm_endpoint_slot_in_use(&endpoint, second.slot_index));
+  ASSERT_TRUE(open_shm_transport(&third, name.c_str()));
+  close_shm_transport(&third);
+}
@@ -29,6 +29,7 @@
 #include "rmw/validate_node_name.h"
 
 #include "./config.h"
+#include "./rmw_subscriber.h"
 
 #include "./test_utils.hpp"
 
@@ -271,3 +272,67 @@ TEST_F(TestSubscription, memory_poll_shared_topic) {
     subscriptions.clear();
   }
 }
+
+
+/*
+   Testing keep last and keep all subscription histories.
+ */
+TEST_F(TestSubscription, history_depth) {
+  dummy_type_support_t dummy_type_support;
+  ConfigureDummyTypeSupport(
+    topic_type,
+    topic_type,
+    package_name,
+    id_gen++,
+    &dummy_type_support);
+
+  rmw_qos_profile_t dummy_qos_policies;
+  ConfigureDefaultQOSPolices(&dummy_qos_policies);
+  dummy_qos_policies.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  dummy_qos_policies.depth = 2;
+
+  rmw_subscription_t * subscription = rmw_create_subscription(
+    this->node,
+    &dummy_type_support.type_support,
+    dummy_type_support.topic_name.data(),
+    &dummy_qos_policies,
+    true);
+  ASSERT_NE((void *)subscription, (void *)NULL);
+
+  CustomSubscription * custom_subscription =
+    reinterpret_cast<CustomSubscription *>(subscription->data);
+  ASSERT_EQ(custom_subscription->history_depth, 2u);
+
+  uint8_t samples[3] = {1, 2, 3};
+  ucdrBuffer sample_buffer;
+  for (size_t i = 0; i < sizeof(samples); i++) {
+    ucdr_init_buffer(&sample_buffer, &samples[i], 1);
+    ASSERT_TRUE(push_subscription_sample(custom_subscription, &sample_buffer));
+  }
+
+  // Keep last drops the oldest sample
+  ASSERT_EQ(custom_subscription->history_count, 2u);
+  ASSERT_TRUE(front_subscription_sample(custom_subscription, &sample_buffer));
+  ASSERT_EQ(*sample_buffer.iterator, 2);
+  pop_subscription_sample(custom_subscription);
+  ASSERT_TRUE(front_subscription_sample(custom_subscription, &sample_buffer));
+  ASSERT_EQ(*sample_buffer.iterator, 3);
+  pop_subscription_sample(custom_subscription);
+  ASSERT_FALSE(front_subscription_sample(custom_subscription, &sample_buffer));
+
+  // Keep all refuses samples once the history is full
+  dummy_qos_policies.history = RMW_QOS_POLICY_HISTORY_KEEP_ALL;
+  init_subscription_history(custom_subscription, &dummy_qos_policies);
+  ASSERT_EQ(custom_subscription->history_depth, (size_t)MAX_HISTORY_X_SUBSCRIPTION);
+  for (size_t i = 0; i < MAX_HISTORY_X_SUBSCRIPTION; i++) {
+    ucdr_init_buffer(&sample_buffer, &samples[i % sizeof(samples)], 1);
+    ASSERT_TRUE(push_subscription_sample(custom_subscription, &sample_buffer));
+  }
+  ucdr_init_buffer(&sample_buffer, &samples[0], 1);
+  ASSERT_FALSE(push_subscription_sample(custom_subscription, &sample_buffer));
+  ASSERT_TRUE(front_subscription_sample(custom_subscription, &sample_buffer));
+  ASSERT_EQ(*sample_buffer.iterator, 1);
+
+  rmw_ret_t ret = rmw_destroy_subscription(this->node, subscription);
+  ASSERT_EQ(ret, RMW_RET_OK);
+}
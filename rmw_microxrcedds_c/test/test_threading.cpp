@@ -0,0 +1,212 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rosidl_typesupport_microxrcedds_shared/identifier.h>
+#include <rosidl_typesupport_microxrcedds_shared/message_type_support.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/error_handling.h"
+#include "rmw/node_security_options.h"
+#include "rmw/rmw.h"
+
+#include "./config.h"
+
+#include "./test_utils.hpp"
+
+#define MICROXRCEDDS_PADDING sizeof(uint32_t)
+
+const char * stress_message = "Stress message XXXX";
+
+class TestThreading : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    #ifndef _WIN32
+    freopen("/dev/null", "w", stderr);
+    #endif
+  }
+
+  void SetUp()
+  {
+    rmw_ret_t ret = rmw_init();
+    ASSERT_EQ(ret, RMW_RET_OK);
+
+    rmw_node_security_options_t security_options;
+    node = rmw_create_node("stress_node", "/ns", 0, &security_options);
+    ASSERT_NE((void *)node, (void *)NULL);
+
+    ConfigureDummyTypeSupport(
+      topic_type,
+      topic_type,
+      package_name,
+      0,
+      &dummy_type_support);
+    dummy_type_support.callbacks.cdr_serialize =
+      [](const void * untyped_ros_message, ucdrBuffer * cdr) -> bool {
+        return ucdr_serialize_string(cdr, reinterpret_cast<const char *>(untyped_ros_message));
+      };
+    dummy_type_support.callbacks.cdr_deserialize =
+      [](ucdrBuffer * cdr, void * untyped_ros_message, uint8_t * raw_mem_ptr,
+        size_t raw_mem_size) -> bool {
+        bool ok = ucdr_deserialize_string(cdr, reinterpret_cast<char *>(raw_mem_ptr),
+            raw_mem_size);
+        *(reinterpret_cast<char **>(untyped_ros_message)) = reinterpret_cast<char *>(raw_mem_ptr);
+        return ok;
+      };
+    dummy_type_support.callbacks.get_serialized_size = [](const void *) -> uint32_t {
+        return MICROXRCEDDS_PADDING + ucdr_alignment(0, MICROXRCEDDS_PADDING) + strlen(
+          stress_message) + 8;
+      };
+
+    ConfigureDefaultQOSPolices(&qos_policies);
+  }
+
+  void TearDown()
+  {
+    ASSERT_EQ(rmw_destroy_node(node), RMW_RET_OK);
+  }
+
+  rmw_node_t * node;
+  dummy_type_support_t dummy_type_support;
+  rmw_qos_profile_t qos_policies;
+
+  const char * topic_type = "topic_type";
+  const char * package_name = "package_name";
+};
+
+/*
+   Testing two threads publishing while a third one waits and takes on the same node.
+ */
+TEST_F(TestThreading, concurrent_publish_and_wait) {
+  const size_t publisher_threads = 2;
+  const size_t messages_x_thread = 200;
+
+  std::vector<rmw_publisher_t *> publishers;
+  for (size_t i = 0; i < publisher_threads; i++) {
+    rmw_publisher_t * publisher = rmw_create_publisher(node, &dummy_type_support.type_support,
+        dummy_type_support.topic_name.data(), &qos_policies);
+    ASSERT_NE((void *)publisher, (void *)NULL);
+    publishers.push_back(publisher);
+  }
+  rmw_subscription_t * subscription = rmw_create_subscription(node,
+      &dummy_type_support.type_support, dummy_type_support.topic_name.data(), &qos_policies,
+      false);
+  ASSERT_NE((void *)subscription, (void *)NULL);
+
+  std::atomic<size_t> publish_errors(0);
+  std::atomic<bool> publishing(true);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < publisher_threads; i++) {
+    threads.emplace_back([&, i]() {
+        for (size_t j = 0; j < messages_x_thread; j++) {
+          if (rmw_publish(publishers[i], stress_message) != RMW_RET_OK) {
+            publish_errors++;
+          }
+        }
+      });
+  }
+
+  // Every sample that makes it through must be intact
+  size_t received = 0;
+  size_t corrupted = 0;
+  std::thread waiter([&]() {
+      rmw_time_t wait_timeout;
+      wait_timeout.sec = 0;
+      wait_timeout.nsec = 50000000;
+      size_t idle_waits = 0;
+      while (publishing || idle_waits < 10) {
+        void * subscriber = subscription->data;
+        rmw_subscriptions_t subscriptions;
+        subscriptions.subscribers = &subscriber;
+        subscriptions.subscriber_count = 1;
+        if (rmw_wait(&subscriptions, NULL, NULL, NULL, NULL, &wait_timeout) != RMW_RET_OK) {
+          idle_waits += publishing ? 0 : 1;
+          continue;
+        }
+
+        char * message;
+        bool taken = true;
+        while (taken) {
+          if (rmw_take_with_info(subscription, &message, &taken, NULL) != RMW_RET_OK) {
+            corrupted++;
+            break;
+          }
+          if (taken) {
+            received++;
+            if (strcmp(message, stress_message) != 0) {
+              corrupted++;
+            }
+          }
+        }
+      }
+    });
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  publishing = false;
+  waiter.join();
+
+  ASSERT_EQ(publish_errors, 0u);
+  ASSERT_EQ(corrupted, 0u);
+  ASSERT_GT(received, 0u);
+
+  ASSERT_EQ(rmw_destroy_subscription(node, subscription), RMW_RET_OK);
+  for (auto publisher : publishers) {
+    ASSERT_EQ(rmw_destroy_publisher(node, publisher), RMW_RET_OK);
+  }
+}
+
+/*
+   Testing publishers created and destroyed from several threads on the same node.
+ */
+TEST_F(TestThreading, concurrent_creation) {
+  const size_t creation_threads = 2;
+  const size_t rounds = 20;
+  static_assert(MAX_PUBLISHERS_X_NODE >= 2, "needs a publisher per thread");
+
+  std::atomic<size_t> errors(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < creation_threads; i++) {
+    threads.emplace_back([&]() {
+        for (size_t j = 0; j < rounds; j++) {
+          rmw_publisher_t * publisher = rmw_create_publisher(node,
+              &dummy_type_support.type_support, dummy_type_support.topic_name.data(),
+              &qos_policies);
+          if (publisher == NULL) {
+            errors++;
+            continue;
+          }
+          if (rmw_publish(publisher, stress_message) != RMW_RET_OK) {
+            errors++;
+          }
+          if (rmw_destroy_publisher(node, publisher) != RMW_RET_OK) {
+            errors++;
+          }
+        }
+      });
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(errors, 0u);
+}
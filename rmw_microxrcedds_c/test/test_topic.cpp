@@ -145,7 +145,7 @@ TEST_F(TestTopic, multiple_topic_creation) {
 
   std::vector<custom_topic_t *> created_topics;
   std::vector<dummy_type_support_t> dummy_type_supports;
-  for (size_t i = 0; i < attempts; i++) {
+  for (size_t i = 0; i < MAX_TOPICS_X_NODE; i++) {
     dummy_type_supports.push_back(dummy_type_support_t());
     ConfigureDummyTypeSupport(
       topic_type,
@@ -166,10 +166,66 @@ TEST_F(TestTopic, multiple_topic_creation) {
     created_topics.push_back(created_topic);
   }
 
+  // The topic pool is exhausted
+  {
+    dummy_type_supports.push_back(dummy_type_support_t());
+    ConfigureDummyTypeSupport(
+      topic_type,
+      topic_type,
+      package_name,
+      id_gen++,
+      &dummy_type_supports.back());
+
+    custom_topic_t * created_topic = create_topic(
+      reinterpret_cast<struct CustomNode *>(node->data),
+      dummy_type_supports.back().topic_name.data(),
+      &dummy_type_supports.back().callbacks,
+      &dummy_qos_policies);
+    ASSERT_EQ((void *)created_topic, (void *)NULL);
+  }
+
   for (size_t i = 0; i < created_topics.size(); i++) {
-    ASSERT_EQ(topic_count(reinterpret_cast<struct CustomNode *>(node->data)), attempts - i);
+    ASSERT_EQ(topic_count(reinterpret_cast<struct CustomNode *>(node->data)),
+      created_topics.size() - i);
     bool ret = destroy_topic(created_topics.at(i));
     ASSERT_EQ(ret, true);
   }
   ASSERT_EQ(topic_count(reinterpret_cast<struct CustomNode *>(node->data)), 0);
 }
+
+
+/*
+   Testing topics of the same type with different names
+ */
+TEST_F(TestTopic, same_type_different_names) {
+  dummy_type_support_t dummy_type_support;
+  ConfigureDummyTypeSupport(
+    topic_type,
+    topic_type,
+    package_name,
+    id_gen++,
+    &dummy_type_support);
+
+  rmw_qos_profile_t dummy_qos_policies;
+  ConfigureDefaultQOSPolices(&dummy_qos_policies);
+
+  custom_topic_t * first_topic = create_topic(
+    reinterpret_cast<struct CustomNode *>(node->data),
+    "/first_topic",
+    &dummy_type_support.callbacks,
+    &dummy_qos_policies);
+  ASSERT_NE((void *)first_topic, (void *)NULL);
+
+  custom_topic_t * second_topic = create_topic(
+    reinterpret_cast<struct CustomNode *>(node->data),
+    "/second_topic",
+    &dummy_type_support.callbacks,
+    &dummy_qos_policies);
+  ASSERT_NE((void *)second_topic, (void *)NULL);
+  ASSERT_NE((void *)first_topic, (void *)second_topic);
+  ASSERT_EQ(topic_count(reinterpret_cast<struct CustomNode *>(node->data)), 2u);
+
+  ASSERT_EQ(destroy_topic(first_topic), true);
+  ASSERT_EQ(destroy_topic(second_topic), true);
+  ASSERT_EQ(topic_count(reinterpret_cast<struct CustomNode *>(node->data)), 0u);
+}
@@ -0,0 +1,99 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "./udp6_transport.h"
+
+/*
+   Testing the agent addresses accepted, with their family and scope.
+ */
+TEST(TestUdp6Transport, resolve) {
+  struct sockaddr_storage addr;
+  socklen_t length;
+  ASSERT_TRUE(resolve_udp_address("127.0.0.1", 8888, &addr, &length));
+  ASSERT_EQ(addr.ss_family, AF_INET);
+  ASSERT_EQ(ntohs(reinterpret_cast<struct sockaddr_in *>(&addr)->sin_port), 8888);
+
+  ASSERT_TRUE(resolve_udp_address("[2001:db8::1]", 8888, &addr, &length));
+  ASSERT_EQ(addr.ss_family, AF_INET6);
+  ASSERT_EQ(length, sizeof(struct sockaddr_in6));
+  ASSERT_EQ(ntohs(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_port), 8888);
+
+  // Link-local addresses keep the interface they were given
+  ASSERT_TRUE(resolve_udp_address("fe80::1%lo", 8888, &addr, &length));
+  ASSERT_EQ(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_scope_id,
+    if_nametoindex("lo"));
+
+  ASSERT_FALSE(resolve_udp_address("agent.local", 8888, &addr, &length));
+  ASSERT_FALSE(resolve_udp_address("", 8888, &addr, &length));
+
+  ASSERT_TRUE(is_ipv6_address("::1"));
+  ASSERT_TRUE(is_ipv6_address("[fe80::1%eth0]"));
+  ASSERT_FALSE(is_ipv6_address("127.0.0.1"));
+}
+
+/*
+   Testing an exchange with an agent stand-in on the IPv6 loopback.
+ */
+TEST(TestUdp6Transport, exchange) {
+  int peer = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (peer < 0) {
+    // No IPv6 on this host
+    return;
+  }
+  struct sockaddr_in6 peer_addr;
+  memset(&peer_addr, 0, sizeof(peer_addr));
+  peer_addr.sin6_family = AF_INET6;
+  peer_addr.sin6_addr = in6addr_loopback;
+  socklen_t length = sizeof(peer_addr);
+  ASSERT_EQ(bind(peer, reinterpret_cast<struct sockaddr *>(&peer_addr), sizeof(peer_addr)), 0);
+  ASSERT_EQ(getsockname(peer, reinterpret_cast<struct sockaddr *>(&peer_addr), &length), 0);
+
+  Udp6Transport transport;
+  ASSERT_TRUE(open_udp6_transport(&transport, "::1", ntohs(peer_addr.sin6_port)));
+
+  const uint8_t request[] = {1, 2, 3};
+  ASSERT_TRUE(transport.comm.send_msg(&transport, request, sizeof(request)));
+  uint8_t received[16];
+  struct sockaddr_in6 client_addr;
+  length = sizeof(client_addr);
+  ASSERT_EQ(recvfrom(peer, received, sizeof(received), 0,
+    reinterpret_cast<struct sockaddr *>(&client_addr), &length),
+    static_cast<ssize_t>(sizeof(request)));
+  ASSERT_EQ(memcmp(received, request, sizeof(request)), 0);
+
+  const uint8_t reply[] = {4, 5};
+  ASSERT_EQ(sendto(peer, reply, sizeof(reply), 0,
+    reinterpret_cast<struct sockaddr *>(&client_addr), length),
+    static_cast<ssize_t>(sizeof(reply)));
+  uint8_t * buffer;
+  size_t buffer_length;
+  ASSERT_TRUE(transport.comm.recv_msg(&transport, &buffer, &buffer_length, 1000));
+  ASSERT_EQ(buffer_length, sizeof(reply));
+  ASSERT_EQ(memcmp(buffer, reply, sizeof(reply)), 0);
+  ASSERT_FALSE(transport.comm.recv_msg(&transport, &buffer, &buffer_length, 10));
+
+  close_udp6_transport(&transport);
+  close(peer);
+}
@@ -0,0 +1,120 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "./udp_batch_transport.h"
+
+class TestUdpBatchTransport : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    // Agent stand-in on loopback
+    peer = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(peer, 0);
+    struct sockaddr_in peer_addr;
+    memset(&peer_addr, 0, sizeof(peer_addr));
+    peer_addr.sin_family = AF_INET;
+    peer_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(peer_addr);
+    ASSERT_EQ(bind(peer, reinterpret_cast<struct sockaddr *>(&peer_addr), sizeof(peer_addr)), 0);
+    ASSERT_EQ(getsockname(peer, reinterpret_cast<struct sockaddr *>(&peer_addr), &length), 0);
+
+    transport = new UdpBatchTransport();
+    ASSERT_TRUE(open_udp_batch_transport(transport, "127.0.0.1", ntohs(peer_addr.sin_port)));
+
+    // The peer learns the client address from its first datagram
+    const uint8_t hello = 0;
+    ASSERT_TRUE(transport->comm.send_msg(transport, &hello, sizeof(hello)));
+    flush_udp_batch_transport(transport);
+    uint8_t buffer;
+    length = sizeof(client_addr);
+    ASSERT_EQ(recvfrom(peer, &buffer, sizeof(buffer), 0,
+      reinterpret_cast<struct sockaddr *>(&client_addr), &length), 1);
+  }
+
+  void TearDown()
+  {
+    close_udp_batch_transport(transport);
+    delete transport;
+    close(peer);
+  }
+
+  size_t PendingAtPeer()
+  {
+    size_t count = 0;
+    uint8_t buffer[UXR_CONFIG_UDP_TRANSPORT_MTU];
+    while (recv(peer, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+      count++;
+    }
+    return count;
+  }
+
+  int peer;
+  struct sockaddr_in client_addr;
+  UdpBatchTransport * transport;
+};
+
+/*
+   Testing that queued datagrams are drained with a single call and read in order.
+ */
+TEST_F(TestUdpBatchTransport, batched_reads) {
+  const uint8_t count = UDP_BATCH_SIZE / 2;
+  for (uint8_t i = 0; i < count; i++) {
+    ASSERT_EQ(sendto(peer, &i, sizeof(i), 0, reinterpret_cast<struct sockaddr *>(&client_addr),
+      sizeof(client_addr)), 1);
+  }
+
+  size_t recv_calls = transport->recv_calls;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t * buffer;
+    size_t length;
+    ASSERT_TRUE(transport->comm.recv_msg(transport, &buffer, &length, 1000));
+    ASSERT_EQ(length, 1u);
+    ASSERT_EQ(buffer[0], i);
+  }
+  ASSERT_EQ(transport->recv_calls - recv_calls, 1u);
+}
+
+/*
+   Testing that writes wait for the next read, a flush or a full batch.
+ */
+TEST_F(TestUdpBatchTransport, batched_writes) {
+  const uint8_t message = 1;
+  ASSERT_TRUE(transport->comm.send_msg(transport, &message, sizeof(message)));
+  ASSERT_TRUE(transport->comm.send_msg(transport, &message, sizeof(message)));
+  ASSERT_EQ(PendingAtPeer(), 0u);
+
+  uint8_t * buffer;
+  size_t length;
+  ASSERT_FALSE(transport->comm.recv_msg(transport, &buffer, &length, 10));
+  ASSERT_EQ(PendingAtPeer(), 2u);
+
+  size_t send_calls = transport->send_calls;
+  for (size_t i = 0; i < UDP_BATCH_SIZE; i++) {
+    ASSERT_TRUE(transport->comm.send_msg(transport, &message, sizeof(message)));
+  }
+  ASSERT_EQ(transport->send_calls - send_calls, 1u);
+  ASSERT_EQ(PendingAtPeer(), static_cast<size_t>(UDP_BATCH_SIZE));
+
+  ASSERT_FALSE(transport->comm.send_msg(transport, &message, UXR_CONFIG_UDP_TRANSPORT_MTU + 1));
+}
@@ -0,0 +1,64 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Prints the memory footprint of the rmw_microxrcedds.config the library was built with.
+// Usage: rmw_microxrcedds_footprint [nodes publishers subscriptions topics history_x_sub history]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rmw/error_handling.h>
+
+#include "rmw_microxrcedds.h"
+
+int main(int argc, char ** argv)
+{
+  rmw_uxrce_limits_t limits;
+  rmw_uxrce_get_limits(&limits);
+
+  if (argc == 7) {
+    limits.max_nodes = strtoul(argv[1], NULL, 10);
+    limits.max_publishers_x_node = strtoul(argv[2], NULL, 10);
+    limits.max_subscriptions_x_node = strtoul(argv[3], NULL, 10);
+    limits.max_topics_x_node = strtoul(argv[4], NULL, 10);
+    limits.max_history_x_subscription = strtoul(argv[5], NULL, 10);
+    limits.max_history = strtoul(argv[6], NULL, 10);
+  } else if (argc != 1) {
+    fprintf(stderr,
+      "usage: %s [nodes publishers subscriptions topics history_x_sub history]\n", argv[0]);
+    return 1;
+  }
+
+  rmw_uxrce_footprint_t footprint;
+  if (RMW_RET_OK != rmw_uxrce_get_footprint(&limits, &footprint)) {
+    fprintf(stderr, "%s\n", rmw_get_error_string_safe());
+    return 1;
+  }
+
+  printf("limits: %zu nodes, %zu publishers, %zu subscriptions, %zu topics per node, "
+    "%zu samples per subscription, %zu stream slots\n",
+    limits.max_nodes, limits.max_publishers_x_node, limits.max_subscriptions_x_node,
+    limits.max_topics_x_node, limits.max_history_x_subscription, limits.max_history);
+  printf("node:            %8zu bytes\n", footprint.node);
+  printf("stream:          %8zu bytes (2 per node)\n", footprint.stream);
+  printf("publish queue:   %8zu bytes\n", footprint.publish_queue);
+  printf("publisher:       %8zu bytes\n", footprint.publisher);
+  printf("subscription:    %8zu bytes\n", footprint.subscription);
+  printf("topic:           %8zu bytes\n", footprint.topic);
+  printf("guard condition: %8zu bytes\n", footprint.guard_condition);
+  printf("wait set:        %8zu bytes\n", footprint.wait_set);
+  printf("node arena:      %8zu bytes\n", footprint.node_arena);
+  printf("total:           %8zu bytes\n", footprint.total);
+  return 0;
+}
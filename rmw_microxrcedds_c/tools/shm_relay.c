@@ -0,0 +1,135 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Bridges the shared memory transport to a UDP agent on the same host, one UDP socket
+// per client slot so the agent sees every session as a separate client.
+// Usage: rmw_microxrcedds_shm_relay [name agent_ip agent_port slots ring_size]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "./shm_transport.h"
+#include "./udp6_transport.h"
+
+#define MAX_RELAY_SLOTS 32
+#define RELAY_BUFFER_SIZE 65535
+
+static volatile sig_atomic_t running = 1;
+
+static void stop_relay(int signal_number)
+{
+  (void)signal_number;
+  running = 0;
+}
+
+int main(int argc, char ** argv)
+{
+  const char * name = DEFAULT_SHM_NAME;
+  const char * agent_ip = "127.0.0.1";
+  unsigned long agent_port = 8888;
+  unsigned long slots = 4;
+  unsigned long ring_size = 16384;
+
+  if (argc == 6) {
+    name = argv[1];
+    agent_ip = argv[2];
+    agent_port = strtoul(argv[3], NULL, 10);
+    slots = strtoul(argv[4], NULL, 10);
+    ring_size = strtoul(argv[5], NULL, 10);
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [name agent_ip agent_port slots ring_size]\n", argv[0]);
+    return 1;
+  }
+  if ((slots == 0) || (slots > MAX_RELAY_SLOTS) || (agent_port == 0) || (agent_port > 65535)) {
+    fprintf(stderr, "slots must be in [1, %d] and the agent port in [1, 65535]\n",
+      MAX_RELAY_SLOTS);
+    return 1;
+  }
+
+  struct sockaddr_storage agent_addr;
+  socklen_t agent_addr_length;
+  if (!resolve_udp_address(agent_ip, (uint16_t)agent_port, &agent_addr, &agent_addr_length)) {
+    fprintf(stderr, "invalid agent address %s\n", agent_ip);
+    return 1;
+  }
+
+  ShmEndpoint endpoint;
+  if (!create_shm_endpoint(&endpoint, name, slots, ring_size)) {
+    fprintf(stderr, "can not create segment %s, the ring size must be a power of two\n", name);
+    return 1;
+  }
+  signal(SIGINT, stop_relay);
+  signal(SIGTERM, stop_relay);
+  printf("relaying %s (%lu slots) to %s:%lu\n", name, slots, agent_ip, agent_port);
+
+  static uint8_t buffer[RELAY_BUFFER_SIZE];
+  int sockets[MAX_RELAY_SLOTS];
+  for (size_t i = 0; i < MAX_RELAY_SLOTS; i++) {
+    sockets[i] = -1;
+  }
+
+  while (running) {
+    bool idle = true;
+    for (size_t slot = 0; slot < slots; slot++) {
+      if (!shm_endpoint_slot_in_use(&endpoint, slot)) {
+        // The next client of this slot gets a fresh source port
+        if (sockets[slot] >= 0) {
+          close(sockets[slot]);
+          sockets[slot] = -1;
+        }
+        continue;
+      }
+      if (sockets[slot] < 0) {
+        sockets[slot] = socket(agent_addr.ss_family, SOCK_DGRAM, 0);
+        if (sockets[slot] < 0) {
+          continue;
+        }
+      }
+
+      size_t length;
+      while (shm_endpoint_read(&endpoint, slot, buffer, sizeof(buffer), &length)) {
+        sendto(sockets[slot], buffer, length, 0, (struct sockaddr *)&agent_addr,
+          agent_addr_length);
+        idle = false;
+      }
+
+      ssize_t received;
+      while ((received = recv(sockets[slot], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        // A full ring drops the datagram, as the network would
+        shm_endpoint_write(&endpoint, slot, buffer, (size_t)received);
+        idle = false;
+      }
+    }
+
+    if (idle) {
+      struct timespec pause = {0, 50000};
+      nanosleep(&pause, NULL);
+    }
+  }
+
+  for (size_t slot = 0; slot < slots; slot++) {
+    if (sockets[slot] >= 0) {
+      close(sockets[slot]);
+    }
+  }
+  destroy_shm_endpoint(&endpoint);
+  return 0;
+}
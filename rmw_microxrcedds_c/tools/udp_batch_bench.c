@@ -0,0 +1,175 @@
+// Copyright 2018 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the batched UDP transport against one syscall per datagram over loopback.
+// Bursts of datagrams are queued by a peer socket and the time to drain or send each
+// burst is measured on both paths.
+// Usage: rmw_microxrcedds_udp_batch_bench [rounds burst message_size]
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "./udp_batch_transport.h"
+
+static int64_t now_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Learns the address of a client from the first datagram it sends.
+static bool accept_client(int peer, struct sockaddr_in * client)
+{
+  uint8_t hello;
+  socklen_t length = sizeof(*client);
+  return recvfrom(peer, &hello, sizeof(hello), 0, (struct sockaddr *)client, &length) == 1;
+}
+
+static void send_burst(int peer, const struct sockaddr_in * client, const uint8_t * message,
+  size_t message_size, size_t burst)
+{
+  for (size_t i = 0; i < burst; i++) {
+    sendto(peer, message, message_size, 0, (const struct sockaddr *)client, sizeof(*client));
+  }
+}
+
+static void drain_burst(int peer, size_t burst)
+{
+  uint8_t buffer[UXR_CONFIG_UDP_TRANSPORT_MTU];
+  for (size_t i = 0; i < burst; i++) {
+    recv(peer, buffer, sizeof(buffer), 0);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  unsigned long rounds = 10000;
+  unsigned long burst = UDP_BATCH_SIZE;
+  unsigned long message_size = 64;
+  if (argc == 4) {
+    rounds = strtoul(argv[1], NULL, 10);
+    burst = strtoul(argv[2], NULL, 10);
+    message_size = strtoul(argv[3], NULL, 10);
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [rounds burst message_size]\n", argv[0]);
+    return 1;
+  }
+  if ((rounds == 0) || (burst == 0) || (message_size == 0) ||
+    (message_size > UXR_CONFIG_UDP_TRANSPORT_MTU))
+  {
+    fprintf(stderr, "message size must be in [1, %d]\n", UXR_CONFIG_UDP_TRANSPORT_MTU);
+    return 1;
+  }
+
+  // Agent stand-in
+  int peer = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in peer_addr;
+  memset(&peer_addr, 0, sizeof(peer_addr));
+  peer_addr.sin_family = AF_INET;
+  peer_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t peer_length = sizeof(peer_addr);
+  if ((peer < 0) || (bind(peer, (struct sockaddr *)&peer_addr, sizeof(peer_addr)) != 0) ||
+    (getsockname(peer, (struct sockaddr *)&peer_addr, &peer_length) != 0))
+  {
+    fprintf(stderr, "can not bind the loopback peer\n");
+    return 1;
+  }
+
+  static UdpBatchTransport batch;
+  int plain = socket(AF_INET, SOCK_DGRAM, 0);
+  if (!open_udp_batch_transport(&batch, "127.0.0.1", ntohs(peer_addr.sin_port)) ||
+    (plain < 0) || (connect(plain, (struct sockaddr *)&peer_addr, sizeof(peer_addr)) != 0))
+  {
+    fprintf(stderr, "can not connect to the loopback peer\n");
+    return 1;
+  }
+
+  const uint8_t hello = 0;
+  struct sockaddr_in batch_addr;
+  struct sockaddr_in plain_addr;
+  batch.comm.send_msg(&batch, &hello, sizeof(hello));
+  flush_udp_batch_transport(&batch);
+  send(plain, &hello, sizeof(hello), 0);
+  if (!accept_client(peer, &batch_addr) || !accept_client(peer, &plain_addr)) {
+    fprintf(stderr, "loopback handshake failed\n");
+    return 1;
+  }
+
+  uint8_t * message = calloc(message_size, 1);
+  uint8_t buffer[UXR_CONFIG_UDP_TRANSPORT_MTU];
+  int64_t plain_recv_ns = 0;
+  int64_t batch_recv_ns = 0;
+  int64_t plain_send_ns = 0;
+  int64_t batch_send_ns = 0;
+  size_t batch_recv_calls = batch.recv_calls;
+  size_t batch_send_calls = batch.send_calls;
+
+  for (unsigned long round = 0; round < rounds; round++) {
+    send_burst(peer, &plain_addr, message, message_size, burst);
+    int64_t start = now_ns();
+    for (unsigned long i = 0; i < burst; i++) {
+      recv(plain, buffer, sizeof(buffer), 0);
+    }
+    plain_recv_ns += now_ns() - start;
+
+    send_burst(peer, &batch_addr, message, message_size, burst);
+    start = now_ns();
+    for (unsigned long i = 0; i < burst; i++) {
+      uint8_t * received;
+      size_t length;
+      batch.comm.recv_msg(&batch, &received, &length, 1000);
+    }
+    batch_recv_ns += now_ns() - start;
+
+    start = now_ns();
+    for (unsigned long i = 0; i < burst; i++) {
+      send(plain, message, message_size, 0);
+    }
+    plain_send_ns += now_ns() - start;
+    drain_burst(peer, burst);
+
+    start = now_ns();
+    for (unsigned long i = 0; i < burst; i++) {
+      batch.comm.send_msg(&batch, message, message_size);
+    }
+    flush_udp_batch_transport(&batch);
+    batch_send_ns += now_ns() - start;
+    drain_burst(peer, burst);
+  }
+
+  double messages = (double)rounds * (double)burst;
+  printf("%lu rounds of %lu datagrams of %lu bytes, batch size %d\n", rounds, burst,
+    message_size, UDP_BATCH_SIZE);
+  printf("recv: %8.1f ns/msg per datagram, %8.1f ns/msg batched (%.3f syscalls/msg)\n",
+    (double)plain_recv_ns / messages, (double)batch_recv_ns / messages,
+    (double)(batch.recv_calls - batch_recv_calls) / messages);
+  printf("send: %8.1f ns/msg per datagram, %8.1f ns/msg batched (%.3f syscalls/msg)\n",
+    (double)plain_send_ns / messages, (double)batch_send_ns / messages,
+    (double)(batch.send_calls - batch_send_calls) / messages);
+
+  free(message);
+  close_udp_batch_transport(&batch);
+  close(plain);
+  close(peer);
+  return 0;
+}